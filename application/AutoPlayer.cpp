@@ -0,0 +1,256 @@
+#include "AutoPlayer.h"
+
+#include <algorithm>
+#include <array>
+#include <queue>
+
+namespace {
+	inline glm::ivec3 toCell(const Pieces::Offset& offset) {
+		return glm::ivec3(offset.x, offset.y, offset.z);
+	}
+
+	// Cells of an orientation moved so the box around them starts at 0,0,0
+	// and sorted, two orientations with the same cells give the same list
+	std::vector<std::array<int, 3>> normalized(const Pieces::Orientation& piece) {
+		std::vector<std::array<int, 3>> cells;
+		for (int i = 0; i < piece.Count; i++)
+			cells.push_back({ piece.Cells[i].x - piece.Min.x, piece.Cells[i].y - piece.Min.y,
+				piece.Cells[i].z - piece.Min.z });
+		std::sort(cells.begin(), cells.end());
+		return cells;
+	}
+
+	// Shortest list of quarter turn axes from one orientation to another
+	std::vector<int> turnsBetween(int from, int to) {
+		std::array<int, Pieces::OrientationCount> previous;
+		std::array<int, Pieces::OrientationCount> axis;
+		previous.fill(-1);
+		previous[from] = from;
+		std::queue<int> open;
+		open.push(from);
+		while (!open.empty() && previous[to] < 0) {
+			int o = open.front();
+			open.pop();
+			for (int a = 0; a < 3; a++) {
+				int next = Pieces::Turns[o][a];
+				if (previous[next] >= 0)
+					continue;
+				previous[next] = o;
+				axis[next] = a;
+				open.push(next);
+			}
+		}
+		std::vector<int> turns;
+		for (int o = to; o != from; o = previous[o])
+			turns.push_back(axis[o]);
+		std::reverse(turns.begin(), turns.end());
+		return turns;
+	}
+
+	// Turns the active piece of the game to an orientation.
+	// Returns false if it got stuck on the way.
+	bool turnTo(Simulation& game, int orientation, std::vector<Simulation::Input>& inputs) {
+		const Simulation::Input rotations[3] = { Simulation::Input::RotateX,
+			Simulation::Input::RotateY, Simulation::Input::RotateZ };
+		for (int axis : turnsBetween(game.GetActiveOrientationIndex(), orientation)) {
+			if (!game.Apply(rotations[axis]))
+				return false;
+			inputs.push_back(rotations[axis]);
+		}
+		return true;
+	}
+
+	// The moves across the layer, in the same order as the offsets below
+	const Simulation::Input layerMoves[4] = { Simulation::Input::Right,
+		Simulation::Input::Left, Simulation::Input::Up, Simulation::Input::Down };
+	const glm::ivec3 layerOffsets[4] = { glm::ivec3(1, 0, 0), glm::ivec3(-1, 0, 0),
+		glm::ivec3(0, 1, 0), glm::ivec3(0, -1, 0) };
+
+	// Breadth first flood fill of the cells the pivot of a piece can be moved to in the
+	// layer it is in. previous[y * width + x] is the move that reached the
+	// cell, -1 for cells it can not reach and 4 for the start.
+	void floodLayer(const Simulation& game, int shape, int orientation,
+		const glm::ivec3& start, std::vector<int>& previous) {
+		const int width = game.GetPit().GetWidth();
+		previous.assign(static_cast<size_t>(width) * game.GetPit().GetHeight(), -1);
+		previous[start.y * width + start.x] = 4;
+		std::queue<glm::ivec3> open;
+		open.push(start);
+		while (!open.empty()) {
+			glm::ivec3 cell = open.front();
+			open.pop();
+			for (int m = 0; m < 4; m++) {
+				glm::ivec3 next = cell + layerOffsets[m];
+				//the pivot is a cube of the piece, so a piece that fits has it in the pit
+				if (!game.Fits(shape, orientation, next) || previous[next.y * width + next.x] >= 0)
+					continue;
+				previous[next.y * width + next.x] = m;
+				open.push(next);
+			}
+		}
+	}
+}
+
+AutoPlayer::AutoPlayer(unsigned int threads)
+	: AutoPlayer(threads, Weights()) {
+}
+
+AutoPlayer::AutoPlayer(unsigned int threads, const Weights& weights)
+	: Pool(threads), Score(weights), UniqueOrientations(Pieces::Shapes.size()) {
+	for (size_t s = 0; s < Pieces::Shapes.size(); s++) {
+		std::vector<std::vector<std::array<int, 3>>> seen;
+		for (int o = 0; o < Pieces::OrientationCount; o++) {
+			auto cells = normalized(Pieces::Orientations[s][o]);
+			if (std::find(seen.begin(), seen.end(), cells) != seen.end())
+				continue;
+			seen.push_back(cells);
+			UniqueOrientations[s].push_back(o);
+		}
+	}
+}
+
+float AutoPlayer::Evaluate(const Pit& pit, const Pieces::Orientation& piece,
+	const glm::ivec3& position, int maxHeight) const {
+	std::array<glm::ivec3, Pieces::MaxCells> cells;
+	for (int i = 0; i < piece.Count; i++)
+		cells[i] = position + toCell(piece.Cells[i]);
+
+	int cleared = 0;
+	int holes = 0;
+	int raised = 0;
+	const int layerSize = pit.GetWidth() * pit.GetHeight();
+	for (int i = 0; i < piece.Count; i++) {
+		//every layer and column is looked at from its first cube in the piece
+		bool firstInLayer = true;
+		bool firstInColumn = true;
+		for (int j = 0; j < i; j++) {
+			firstInLayer = firstInLayer && cells[j].z != cells[i].z;
+			firstInColumn = firstInColumn && (cells[j].x != cells[i].x || cells[j].y != cells[i].y);
+		}
+
+		if (firstInLayer) {
+			int count = pit.GetCells().CountCubes(cells[i].z);
+			for (int j = i; j < piece.Count; j++)
+				count += cells[j].z == cells[i].z;
+			cleared += count == layerSize;
+		}
+
+		if (firstInColumn) {
+			//the cubes under the old top fill holes, the empty cells between the
+			// old and the new top become holes
+			const int top = pit.GetColumnTop(cells[i].x, cells[i].y);
+			int newTop = top;
+			int above = 0;
+			for (int j = i; j < piece.Count; j++) {
+				if (cells[j].x != cells[i].x || cells[j].y != cells[i].y)
+					continue;
+				newTop = std::max(newTop, cells[j].z + 1);
+				if (cells[j].z < top)
+					holes--;
+				else
+					above++;
+			}
+			holes += newTop - top - above;
+			raised += newTop - top;
+			maxHeight = std::max(maxHeight, newTop);
+		}
+	}
+
+	return Score.clearedLayers * cleared + Score.holes * holes +
+		Score.aggregateHeight * raised + Score.maxHeight * maxHeight;
+}
+
+AutoPlayer::Placement AutoPlayer::SearchOrientation(const Simulation& game, int orientation,
+	int maxHeight, unsigned long long& evaluated) const {
+	//turns the piece first, a kick may move it and it may not be able to
+	// turn at all where it is
+	const int shape = game.GetActiveShape();
+	int turned = game.GetActiveOrientationIndex();
+	glm::ivec3 start = game.GetActivePosition();
+	for (int axis : turnsBetween(turned, orientation)) {
+		if (!game.FindTurn(shape, turned, start, axis, start))
+			return Placement();
+		turned = Pieces::Turns[turned][axis];
+	}
+
+	const Pieces::Orientation& piece = Pieces::Orientations[shape][orientation];
+	const Pit& pit = game.GetPit();
+	std::vector<int> previous;
+	floodLayer(game, shape, orientation, start, previous);
+
+	Placement best;
+	for (int y = 0; y < pit.GetHeight(); y++) {
+		for (int x = 0; x < pit.GetWidth(); x++) {
+			if (previous[y * pit.GetWidth() + x] < 0)
+				continue;
+			glm::ivec3 position(x, y, start.z);
+			glm::ivec3 landed = position - glm::ivec3(0, 0,
+				game.DropDistance(shape, orientation, position));
+			float score = Evaluate(pit, piece, landed, maxHeight);
+			evaluated++;
+			if (best.orientation < 0 || score > best.score) {
+				best.orientation = orientation;
+				best.position = position;
+				best.score = score;
+			}
+		}
+	}
+	return best;
+}
+
+AutoPlayer::Placement AutoPlayer::FindBest(const Simulation& game) {
+	const Pit& pit = game.GetPit();
+	int maxHeight = 0;
+	for (int y = 0; y < pit.GetHeight(); y++)
+		for (int x = 0; x < pit.GetWidth(); x++)
+			maxHeight = std::max(maxHeight, pit.GetColumnTop(x, y));
+
+	const std::vector<int>& orientations = UniqueOrientations[game.GetActiveShape()];
+	std::vector<Placement> results(orientations.size());
+	std::vector<unsigned long long> evaluated(orientations.size(), 0);
+	for (size_t i = 0; i < orientations.size(); i++) {
+		Pool.Submit([&, i]() {
+			results[i] = SearchOrientation(game, orientations[i], maxHeight, evaluated[i]);
+		});
+	}
+	Pool.Wait();
+
+	//picked in a fixed order so the game plays the same on any number of threads
+	Placement best;
+	for (size_t i = 0; i < results.size(); i++) {
+		EvaluatedCount += evaluated[i];
+		if (results[i].orientation >= 0 &&
+			(best.orientation < 0 || results[i].score > best.score))
+			best = results[i];
+	}
+	return best;
+}
+
+bool AutoPlayer::Play(Simulation& game, std::vector<Simulation::Input>& inputs) {
+	Placement best = FindBest(game);
+	if (best.orientation < 0)
+		return false;
+
+	const int shape = game.GetActiveShape();
+	turnTo(game, best.orientation, inputs);
+
+	//walks the flood fill back from the placement to get the moves there
+	std::vector<int> previous;
+	floodLayer(game, shape, best.orientation, game.GetActivePosition(), previous);
+	std::vector<Simulation::Input> moves;
+	const int width = game.GetPit().GetWidth();
+	glm::ivec3 cell = best.position;
+	for (int m = previous[cell.y * width + cell.x]; m >= 0 && m < 4;
+		m = previous[cell.y * width + cell.x]) {
+		moves.push_back(layerMoves[m]);
+		cell = cell - layerOffsets[m];
+	}
+	for (auto it = moves.rbegin(); it != moves.rend(); ++it) {
+		game.Apply(*it);
+		inputs.push_back(*it);
+	}
+
+	if (game.Apply(Simulation::Input::Drop))
+		inputs.push_back(Simulation::Input::Drop);
+	return true;
+}
@@ -0,0 +1,72 @@
+#ifndef AUTOPLAYER_H_
+#define AUTOPLAYER_H_
+
+#include "Simulation.h"
+#include "ThreadPool.h"
+
+#include <vector>
+
+// =============================================================================
+// AutoPlayer
+// =============================================================================
+// Plays the game on its own. Every place the active piece can be dropped to
+// from the starting layer, in every orientation, is scored on the pit it would
+// leave behind, and the best one is played. The orientations are searched in
+// parallel on a thread pool. A drop is scored by what it changes in the
+// columns and layers it lands in, so the cost does not grow with the pit.
+class AutoPlayer
+{
+public:
+	// How much each property of the pit after a drop counts, higher is better
+	struct Weights
+	{
+		float clearedLayers = 8.0f;		// full layers the drop removes
+		float holes = -5.0f;			// empty cells the drop covers, less the ones it fills
+		float aggregateHeight = -0.5f;	// how much the drop raises the columns
+		float maxHeight = -1.0f;		// highest column after the drop
+	};
+
+	// A place to drop the active piece to
+	struct Placement
+	{
+		int orientation = -1;		// -1 when the piece fits nowhere
+		glm::ivec3 position;		// where the piece is dropped from
+		float score = 0.0f;
+	};
+
+public:
+	// threads - workers searching the placements, 0 for one per core
+	// weights - how the placements are scored
+	explicit AutoPlayer(unsigned int threads = 0);
+	AutoPlayer(unsigned int threads, const Weights& weights);
+
+	// The best place for the active piece of the game
+	Placement FindBest(const Simulation& game);
+
+	// Finds the best placement and plays it: turns the piece, moves it over
+	// and drops it. The inputs given to the game are added to inputs.
+	// Returns false if the piece fits nowhere, which means the pit is full.
+	bool Play(Simulation& game, std::vector<Simulation::Input>& inputs);
+
+	// Placements scored since the start
+	unsigned long long GetEvaluatedCount() const { return EvaluatedCount; }
+	unsigned int GetThreadCount() const { return Pool.GetThreadCount(); }
+
+private:
+	// Best placement of one orientation of the active shape
+	Placement SearchOrientation(const Simulation& game, int orientation, int maxHeight,
+		unsigned long long& evaluated) const;
+	// Score of the piece landed at the position
+	float Evaluate(const Pit& pit, const Pieces::Orientation& piece,
+		const glm::ivec3& position, int maxHeight) const;
+
+private:
+	ThreadPool Pool;
+	Weights Score;
+	// The orientations of every shape with a different set of cells, the
+	// others would only score the same placements again
+	std::vector<std::vector<int>> UniqueOrientations;
+	unsigned long long EvaluatedCount = 0;
+};
+
+#endif // AUTOPLAYER_H_
@@ -1,6 +1,7 @@
 #include "BlockOutApp.h"
 /**
-* You are able to move a cube in a tube that is 5x5x10. the cube can move
+* You are able to move a cube in a tube that is 5x5x10, or any size given with
+* --pit-width, --pit-height and --pit-depth. the cube can move
 * up, down, left and right with the arrow keys and inwards with the X key for
 * one step and SPACE to go to the end of the tube. the cube will become solid
 * when you hit the backwall or another placed cube. there is lighting and
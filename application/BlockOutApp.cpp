@@ -3,10 +3,50 @@
 #include "BufferLayout.h"
 #include "VertexArray.h"
 #include "Shader.h"
+#include "ShaderVariants.h"
 #include "Shaders.h"
 #include "RenderCommands.h"
+#include "RenderQueue.h"
 #include "PerspectiveCamera.h"
 #include "TextureManager.h"
+#include "UniformBuffer.h"
+#include "ShaderStorageBuffer.h"
+#include "OcclusionCuller.h"
+#include "ComputeCuller.h"
+#include "ProgramCache.h"
+#include "GameState.h"
+#include "FixedTimestep.h"
+#include "Simulation.h"
+#include "Replay.h"
+#include "AutoPlayer.h"
+#include "StackMesher.h"
+
+#include <algorithm>
+#include <chrono>
+
+//simulation ticks per second
+constexpr double TickRate = 60.0;
+//time between each step the active cube takes inwards
+constexpr double FallSeconds = 2.0;
+
+/**
+* @brief finds the piece set with the name given on the command line
+*
+* @param const std::string& name - cube, flat, basic or extended
+*
+* @return the piece set, the basic set for unknown names
+*/
+Pieces::Set PieceSetFromName(const std::string& name) {
+	if (name == "cube")
+		return Pieces::Set::Cube;
+	if (name == "flat")
+		return Pieces::Set::Flat;
+	if (name == "extended")
+		return Pieces::Set::Extended;
+	if (name != "basic")
+		std::cerr << "Unknown piece set " << name << ", using basic\n";
+	return Pieces::Set::Basic;
+}
 
 //constructor
 BlockOutApp::BlockOutApp(const std::string& name, const std::string& version) {
@@ -20,273 +60,188 @@ BlockOutApp::~BlockOutApp() {
 //Argument parsing
 unsigned int BlockOutApp::ParseArguments(int argc, char** argv) {
 	GLFWApplication::ParseArguments(argc, argv);
+	//keeps the pit within the sizes the game supports
+	for (int* size : { &pitWidth, &pitHeight, &pitDepth }) {
+		if (*size < Pit::MinSize || *size > Pit::MaxSize) {
+			std::cerr << "Pit sizes go from " << Pit::MinSize << " to " << Pit::MaxSize
+				<< " cells, " << *size << " is clamped\n";
+			*size = std::min(std::max(*size, Pit::MinSize), Pit::MaxSize);
+		}
+	}
 	return 0;
 }
 
 // Initialization 
 unsigned int BlockOutApp::Init() {
-	GLFWApplication::Init();
+	//no window or GL context when running headless
+	if (!headless)
+		GLFWApplication::Init();
 	return 0;
 }
-/**
-* @brief checks if two floats are equal accounting for a 0.0001 difference
-*			since floats are not super accurate
-*
-* @param float a - first float
-* @param float b - second float 
-* 
-* @return true if equal
-*/
-bool floatEqual(float a, float b) {
-	if (a <= b + 0.0001f && a >= b - 0.0001f) {
-		return true;
-	}
-	return false;
-}
 
-/**
-* @brief checks if there is collision in the y direction
-* 
-* @param glm::vec3 cubePos - the active cube position
-* @param std::vector<glm::vec3> cubeTranslationVectors - vector with all the
-			translation vectors for the solid cubes and the starting position
-* @param float dir - position offset from the active cube
-		(for example -0.2f to check if there is a cube under the active cube)
-*
-* @see floatEqual(...)
-* 
-* @return true if there is a collision
-*/
-bool collisonY(glm::vec3 cubePos, std::vector<glm::vec3> cubeTranslationVectors
-				,float dir) {
-	
-	for (int i = 1; i < cubeTranslationVectors.size(); i++)
-	{
-		if (floatEqual(cubeTranslationVectors[i].z, cubePos.z) &&
-			floatEqual(cubeTranslationVectors[i].y, cubePos.y+dir) &&
-			floatEqual(cubeTranslationVectors[i].x, cubePos.x)){
-			return true;
-		}
+//Headless run: plays a recorded input stream, or lets the autoplayer play,
+// without drawing anything and reports how fast the game logic runs
+unsigned int BlockOutApp::RunHeadless() const {
+	std::vector<InputEvent> events;
+	if (!autoplay && !replayFile.empty() && !Replay::Load(replayFile, events))
+		return EXIT_FAILURE;
+
+	//the replay is played over and over until the requested ticks have run
+	const unsigned long long replayLength = events.empty() ? 0 : events.back().tick + 1;
+	const unsigned long long totalTicks = ticks > 0 ? ticks : replayLength;
+	if (totalTicks == 0) {
+		std::cerr << "Nothing to run, give a --replay file or a number of --ticks\n";
+		return EXIT_FAILURE;
 	}
-	return false;
-}
-
-/**
-* @brief checks if there is collision in the x direction
-*
-* @param glm::vec3 cubePos - the active cube position
-* @param std::vector<glm::vec3> cubeTranslationVectors - vector with all the
-			translation vectors for the solid cubes and the starting position
-* @param float dir - position offset from the active cube
-(for example -0.2f to check if there is a cube to the right of the active cube)
-*
-* @see floatEqual(...)
-* 
-* @return true if there is a collision
-*/
-bool collisonX(glm::vec3 cubePos, std::vector<glm::vec3> cubeTranslationVectors
-				, float dir) {
 
-	for (int i = 1; i < cubeTranslationVectors.size(); i++)
-	{
-		if (floatEqual(cubeTranslationVectors[i].z, cubePos.z) &&
-			floatEqual(cubeTranslationVectors[i].y, cubePos.y) &&
-			floatEqual(cubeTranslationVectors[i].x, cubePos.x + dir)) {
-			return true;
+	FixedTimestep timestep(TickRate);
+	Simulation game(pitWidth, pitHeight, pitDepth, timestep.TicksFromSeconds(FallSeconds),
+		PieceSetFromName(pieceSet));
+	size_t next = 0;					//next event to give to the game
+	unsigned long long replayStart = 0;	//tick the replay was started on
+
+	std::unique_ptr<AutoPlayer> player;
+	if (autoplay)
+		player = std::make_unique<AutoPlayer>(threads);
+	std::vector<Simulation::Input> moves;	//moves of the autoplayer
+	bool newPiece = true;					//the active piece was not played yet
+	unsigned long long games = 1;
+
+	auto start = std::chrono::steady_clock::now();
+	for (unsigned long long tick = 0; tick < totalTicks; tick++) {
+		if (player) {
+			if (newPiece) {
+				moves.clear();
+				player->Play(game, moves);
+				newPiece = false;
+			}
+		}
+		else {
+			if (replayLength > 0 && tick - replayStart >= replayLength) {
+				replayStart = tick;
+				next = 0;
+			}
+			while (next < events.size() && events[next].tick + replayStart == tick)
+				game.Apply(events[next++].input);
 		}
-	}
-	return false;
-}
-
-/**
-* @brief checks if there is a collision in z direction
-*
-* @param glm::vec3 cubePos - the active cube position
-* @param std::vector<glm::vec3> cubeTranslationVectors - vector with all the
-			translation vectors for the solid cubes and the starting position
-*
-* @see floatEqual(...)
-* 
-* @return true if there is a collision
-*/
-bool collisionZ(glm::vec3 cubePos, std::vector<glm::vec3> cubeTranslationVectors) {
 
-	for (int i = 0; i < cubeTranslationVectors.size(); i++) {
-		if (floatEqual(cubePos.x, cubeTranslationVectors[i].x) &&
-			floatEqual(cubePos.y, cubeTranslationVectors[i].y) &&
-			floatEqual(cubePos.z - 0.2f, cubeTranslationVectors[i].z))
-			return true;
+		Simulation::TickResult result = game.Tick();
+		if (result.respawned) {
+			newPiece = true;
+			//the autoplayer starts a new game once the pit is full
+			if (player && result.landedCount == 0) {
+				games++;
+				game.Reset(static_cast<std::uint32_t>(games));
+			}
+		}
 	}
-
-	return false;
-}
-
-/**
-* @brief checks if all keys that you are not supposed to be able to hold down are released
-*
-* @param GLFWwindow* window - the window that we are working with
-* @param bool &pressed - if a key is pressed right now
-*/
-void checkReleased(GLFWwindow* window, bool& pressed) {
-	if (glfwGetKey(window, GLFW_KEY_UP) == GLFW_RELEASE && glfwGetKey(window, GLFW_KEY_DOWN) == GLFW_RELEASE &&
-		glfwGetKey(window, GLFW_KEY_LEFT) == GLFW_RELEASE && glfwGetKey(window, GLFW_KEY_RIGHT) == GLFW_RELEASE &&
-		glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_RELEASE && glfwGetKey(window, GLFW_KEY_T) == GLFW_RELEASE &&
-		glfwGetKey(window, GLFW_KEY_X) == GLFW_RELEASE && glfwGetKey(window, GLFW_KEY_L) == GLFW_RELEASE){
-		pressed = false;
+	auto end = std::chrono::steady_clock::now();
+	double seconds = std::chrono::duration<double>(end - start).count();
+
+	std::cout << "Ticks: " << totalTicks << "\n";
+	std::cout << "Landed cubes: " << game.GetLandedCount() << "\n";
+	std::cout << "Cleared layers: " << game.GetClearedLayerCount() << "\n";
+	std::cout << "Time: " << seconds << " s\n";
+	std::cout << "Ticks per second: " << (seconds > 0.0 ? totalTicks / seconds : 0.0) << "\n";
+	if (player) {
+		std::cout << "Games: " << games << "\n";
+		std::cout << "Autoplayer threads: " << player->GetThreadCount() << "\n";
+		std::cout << "Placements evaluated: " << player->GetEvaluatedCount() << "\n";
+		std::cout << "Placements per second: "
+			<< (seconds > 0.0 ? player->GetEvaluatedCount() / seconds : 0.0) << "\n";
 	}
+	return 0;
 }
 
-/**
-* @brief checks what the bottom is on the spot that the active cube is
-*
-* @param glm::vec3 cubePos - the active-cube position
-* @param std::vector<glm::vec3> cubeTranslationVectors - vector with all the
-			translation vectors for the solid cubes and the starting position
-* 
-* @see floatEqual(...)
-* 
-* @return returns the z coordinate that is the bottom
-*/
-float bottom(glm::vec3 cubePos, std::vector<glm::vec3> cubeTranslationVectors) {
-	float bot = 0.1f;
-	for (int i = 1; i < cubeTranslationVectors.size(); i++)
-	{
-		if (floatEqual(cubePos.x, cubeTranslationVectors[i].x) &&
-			floatEqual(cubePos.y, cubeTranslationVectors[i].y)) {
-			bot = cubeTranslationVectors[i].z + 0.2f;
-		}
-	}
-	return bot;
-}
+//a move and when its key went down
+struct PendingInput {
+	double time;
+	Simulation::Input input;
+};
 
 /**
-* @brief movement keys
+* @brief turns a key event into a move for the game or a change of the view,
+	only keys going down count so holding a key does not repeat it
 *
-* @param GLFWwindow* window - the window that we are working with
-* @param glm::vec3 cubePos - the active-cube position
-* @param bool &pressed - if a key is pressed right now
-* @param std::vector<glm::vec3> cubeTranslationVectors - vector with all the
-			translation vectors for the solid cubes and the starting position
+* @param const KeyEvent& event - the key event from the queue of the window
+* @param std::vector<PendingInput>& inputs - the moves for the simulation
+			are added here with the time of the key press
 * @param bool &texture - if texture is supposed to be on or not
 * @param bool &lighting - if lighting is supposed to be on or not
-*
-* @see checkReleased(...)
-* @see collisionX(...)
-* @see collisionY(...)
-* @see collisionZ(...)
-* @see bottom(...)
+* @param bool &quit - if the game is supposed to end
 */
-void keyInput(GLFWwindow* window, glm::vec3& cubePos, bool& pressed,
-	std::vector<glm::vec3> cubeTranslationVectors,bool& texture, int& lighting) {
-	//move the cubeector up
-	if ((glfwGetKey(window, GLFW_KEY_UP) == GLFW_PRESS) && !pressed && cubePos.y<0.4f) {
-
-		if(!collisonY(cubePos,cubeTranslationVectors,0.2f))
-			cubePos.y += 0.2f;
-		pressed = true;
-	}
-
-	//move the cubeector down
-	if ((glfwGetKey(window, GLFW_KEY_DOWN) == GLFW_PRESS) && !pressed && cubePos.y > -0.4f) {
-		if(!collisonY(cubePos, cubeTranslationVectors, -0.2f))
-			cubePos.y -= 0.2f;
-		pressed = true;
-	}
-
-	//move the cubeector left
-	if ((glfwGetKey(window, GLFW_KEY_LEFT) == GLFW_PRESS) && !pressed && cubePos.x > -0.4f) {
-		if (!collisonX(cubePos, cubeTranslationVectors, -0.2f))
-			cubePos.x -= 0.2f;
-		pressed = true;
-	}
-
-	//move the cubeector right
-	if ((glfwGetKey(window, GLFW_KEY_RIGHT) == GLFW_PRESS) && !pressed && cubePos.x < 0.4f) {
-		if (!collisonX(cubePos, cubeTranslationVectors, 0.2f))
-			cubePos.x += 0.2f;
-		pressed = true;
-	}
+void keyInput(const KeyEvent& event, std::vector<PendingInput>& inputs,
+	bool& texture, int& lighting, bool& quit) {
+	if (event.action != GLFW_PRESS)
+		return;
 
+	switch (event.key)
+	{
+	//move the cube up, down, left and right
+	case GLFW_KEY_UP:    inputs.push_back({ event.time, Simulation::Input::Up }); break;
+	case GLFW_KEY_DOWN:  inputs.push_back({ event.time, Simulation::Input::Down }); break;
+	case GLFW_KEY_LEFT:  inputs.push_back({ event.time, Simulation::Input::Left }); break;
+	case GLFW_KEY_RIGHT: inputs.push_back({ event.time, Simulation::Input::Right }); break;
 	//move inwards
-	if ((glfwGetKey(window, GLFW_KEY_X) == GLFW_PRESS) && !pressed && cubePos.z > 0.0f ) {
-		if(!collisionZ(cubePos, cubeTranslationVectors))
-			cubePos.z -= 0.2f;
-		pressed = true;
-	}
-
+	case GLFW_KEY_X:     inputs.push_back({ event.time, Simulation::Input::Inwards }); break;
 	//move to the end
-	if ((glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_PRESS) && !pressed && cubePos.z > 0.0f ) {
-		if(!collisionZ(cubePos, cubeTranslationVectors))
-			cubePos.z = bottom(cubePos, cubeTranslationVectors);
-		pressed = true;
-	}
-
+	case GLFW_KEY_SPACE: inputs.push_back({ event.time, Simulation::Input::Drop }); break;
+	//turn the piece around the x, y and z axes
+	case GLFW_KEY_A:     inputs.push_back({ event.time, Simulation::Input::RotateX }); break;
+	case GLFW_KEY_S:     inputs.push_back({ event.time, Simulation::Input::RotateY }); break;
+	case GLFW_KEY_D:     inputs.push_back({ event.time, Simulation::Input::RotateZ }); break;
 	//enbable/disable textures
-	if ((glfwGetKey(window, GLFW_KEY_T) == GLFW_PRESS) && !pressed) {
-		texture = !texture;
-		pressed = true;
-	}
-
+	case GLFW_KEY_T:     texture = !texture; break;
 	//enbable/disable lighting
-	if ((glfwGetKey(window, GLFW_KEY_L) == GLFW_PRESS) && !pressed) {
-		(lighting == 0) ? lighting = 1 : lighting = 0;
-		pressed = true;
+	case GLFW_KEY_L:     lighting = (lighting == 0) ? 1 : 0; break;
+	//end the game
+	case GLFW_KEY_Q:     quit = true; break;
 	}
-	checkReleased(window, pressed);
-
 }
 /**
-* @brief finds the color for the solid cubes according to the section they are
-	a part of
+* @brief finds the color for the solid cubes according to the layer they are
+	a part of, the colors repeat in deeper pits
 *
-* @param glm::vec3 cubeTranslation - translation for the cube calling
+* @param int layer - the layer of the cube calling, 0 at the back wall
 */
-glm::vec4 findColor(glm::vec3 cubeTranslation) {
-	glm::vec4 color(0.0f, 0.0f, 1.0f,1.0f);
-	
-	if (cubeTranslation.z < 0.21f) {
-		color = glm::vec4(1.0f, 0.5f, 0.5f, 1.0f);
-	}
-	else if (cubeTranslation.z < 0.41f) {
-		color = glm::vec4(0.4f, 0.1f, 0.5f, 1.0f);
-	}
-	else if (cubeTranslation.z < 0.61f) {
-		color = glm::vec4(0.7f, 0.0f, 0.3f, 1.0f);
-	}
-	else if (cubeTranslation.z < 0.81f) {
-		color = glm::vec4(0.5f, 0.3f, 0.5f, 1.0f);
-	}
-	else if (cubeTranslation.z < 1.01f) {
-		color = glm::vec4(0.0f, 1.0f, 1.0f, 1.0f);
-	}
-	else if (cubeTranslation.z < 1.21f) {
-		color = glm::vec4(1.0f, 0.0f, 0.0f, 1.0f);
-	}
-	else if (cubeTranslation.z < 1.41f) {
-		color = glm::vec4(0.3f, 0.5f, 0.1f, 1.0f);
-	}
-	else if (cubeTranslation.z < 1.61f) {
-		color = glm::vec4(0.6f, 0.2f, 1.0f, 1.0f);
-	}
-
-	return color;
+glm::vec4 findColor(int layer) {
+	const glm::vec4 colors[] = {
+		glm::vec4(1.0f, 0.5f, 0.5f, 1.0f),
+		glm::vec4(0.4f, 0.1f, 0.5f, 1.0f),
+		glm::vec4(0.7f, 0.0f, 0.3f, 1.0f),
+		glm::vec4(0.5f, 0.3f, 0.5f, 1.0f),
+		glm::vec4(0.0f, 1.0f, 1.0f, 1.0f),
+		glm::vec4(1.0f, 0.0f, 0.0f, 1.0f),
+		glm::vec4(0.3f, 0.5f, 0.1f, 1.0f),
+		glm::vec4(0.6f, 0.2f, 1.0f, 1.0f),
+		glm::vec4(0.0f, 0.0f, 1.0f, 1.0f)
+	};
+	return colors[layer % (sizeof(colors) / sizeof(colors[0]))];
 }
  //Run function
 unsigned int BlockOutApp::Run() const { // Pure virtual function, it must be redefined
 
-	//struct with the matricies except scale because it the same for all of them
-	struct grid {	
-		glm::mat4 model;
-		glm::mat4 translation;
-		glm::mat4 rotation;
-	};
+	if (headless)
+		return RunHeadless();
+
+	//how long it takes from here to the first frame, most of it linking
+	// the shaders unless they come from the cache
+	const auto startupStart = std::chrono::steady_clock::now();
+	ProgramCache::SetDirectory(shaderCache);
+
+	//where the cells of the pit are in the world
+	const PitSpace space(pitWidth, pitHeight, pitDepth);
 
-	// Create buffers and arrays for the grid
-	auto gridGeometry = GeometricTools::UnitGridGeometry2D(5, 5);
-	auto gridTopology = GeometricTools::unitGridTopology(5, 5);
+	// Create buffers and arrays for the pit, every wall is in one mesh that
+	// never changes with a quad for each cell
+	auto gridGeometry = GeometricTools::PitGeometryWNormals(pitWidth, pitHeight, pitDepth,
+		space.GetCellSize());
+	auto gridTopology = GeometricTools::PitTopology(pitWidth, pitHeight, pitDepth);
 	auto gridVertexArray = std::make_shared<VertexArray>();
 	auto gridIndexBuffer = std::make_shared<IndexBuffer>(gridTopology.data(), gridTopology.size());
-	auto gridBufferLayout = BufferLayout({ {ShaderDataType::Float2, "position"} });
+	auto gridBufferLayout = BufferLayout({ {ShaderDataType::Float3, "position"},
+		{ShaderDataType::Float3, "normal"}, {ShaderDataType::Float2, "texCoords"},
+		{ShaderDataType::Float, "parity"} });
 	auto gridVertexBuffer = std::make_shared<VertexBuffer>(gridGeometry.data(), gridGeometry.size() * sizeof(gridGeometry[0]));
 	gridVertexBuffer->SetLayout(gridBufferLayout);
 	gridVertexArray->AddVertexBuffer(gridVertexBuffer);
@@ -295,125 +250,155 @@ unsigned int BlockOutApp::Run() const { // Pure virtual function, it must be red
 	// camera
 	PerspectiveCamera* cam = new PerspectiveCamera(GLFWApplication::width, GLFWApplication::height);
 
-	//grid-matricies
-	std::vector<grid> grids; // vector with all the grids
-	grids.resize(9);		
-	//the scale is the same for all of them
+	//the pit is scaled up like the cubes in it
 	auto gridScale = glm::scale(glm::mat4(1.0f), glm::vec3(3.0f, 3.0f, 3.0f));
-	/*
-	adding the values to the matricies
-	 the order of the grids are: left back, right back, top back, bottom back
-	 left front, right front, top front, bottom front then the backboard
-	*/
-	for (int i = 0; i <grids.size(); i++)
-	{
-		float rotx = 0.0f;
-		float roty = 0.0f;
-		float rotz = 0.0f;
-		float x = 0.0f;
-		float y = 0.0f;
-		float z = 0.0f;
-
-		if (i % 2 == 1) {
-			z = 0.5f;
-			if (i > 3) {
-				if (i < 6)
-					x = -1.5f;
-				else if (i < 8)
-					y = 1.5f;
-			}
-			else {
-				if (i == 1) {
-					x = -0.5f;
-				}
-				else {
-					y = 0.5f;
-				}
-			}
-		}
-		else {
-			z = -0.5f;
-			if (i > 3) {
-				if (i < 6)
-					x = -1.5f;
-				else if (i < 8)
-					y = 1.5f;
-				else {
-					z = 0.0f;
-				}
-			}
-			else {
-				if (i == 0) {
-					x = -0.5f;
-				}
-				else {
-					y = 0.5f;
-				}
-			}
-		}
-		
-		if (i < 2 ||(i>3&&i<6)) {
-			rotx = 0.0f;
-			roty = 1.0f;
-			rotz = 0.0f;	
-		}
-		else if (i < 4 ||(i>5&&i<8)) {
-			rotx = 1.0f;
-			roty = 0.0f;
-			rotz = 0.0f;
-		}
-		else {
-			rotx = 0.0f;
-			roty = 0.0f;
-			rotz = 1.0f;
-		}
-		grids[i].rotation = glm::rotate(glm::mat4(1.0f), glm::radians(90.0f), glm::vec3(rotx, roty, rotz));		
-		grids[i].translation = glm::translate(glm::mat4(1.0f), glm::vec3(x, y, z));
-		grids[i].model = gridScale * grids[i].rotation * grids[i].translation;
-	}
 
-	auto gridViewProjectionMatrix = cam->GetViewProjectionMatrix();
-	
-	// shaders for grid
-	auto gridShader = std::make_shared<Shader>(Shaders::vertexShader, Shaders::fragmentShader);
-	gridShader->Bind();
-	glm::vec2 gridPos = { 5,5 };
-	gridShader->UploadUniformFloat2("u_divisions", gridPos);
-	gridShader->UploadUniformMat4x4("u_viewProjMat", gridViewProjectionMatrix);
-	gridShader->UploadUniformFloat("u_diffuseStrength", 0.7f);
+	// shaders for grid, a variant for each set of features is made when
+	// the toggles first ask for it
+	ShaderVariants gridShaders(Shaders::vertexShader, Shaders::fragmentShader, Shaders::features,
+		[gridScale](Shader& shader, unsigned int) {
+			shader.UploadUniformFloat("u_diffuseStrength", 0.7f);
+			shader.UploadUniformFloat("u_specularStrenght", 0.7f);
+			shader.UploadUniformMat4x4("u_model", gridScale);
+		});
 
 	// Create buffers and arrays for cubes
-	auto cube = GeometricTools::Cube3DWNormals(5);
+	auto cube = GeometricTools::Cube3DWNormals(1.0f / space.GetCellSize());
 	auto cubeTopology = GeometricTools::cubeTopologyWNormals;
-	auto cubeVertexArray = std::make_shared<VertexArray>();
-	auto cubeIndexBuffer = std::make_shared<IndexBuffer>(cubeTopology.data(), cubeTopology.size());
-	auto cubeBufferLayout = BufferLayout({ {ShaderDataType::Float3, "position"},{ShaderDataType::Float3, "normals"} });
+	auto cubeBufferLayout = BufferLayout({ {ShaderDataType::Float3, "position"},{ShaderDataType::Float3, "normals"},
+		{ShaderDataType::Float2, "edge"} });
 	auto cubeVertexBuffer = std::make_shared<VertexBuffer>(cube.data(), cube.size() * sizeof(cube[0]));
 	cubeVertexBuffer->SetLayout(cubeBufferLayout);
-	cubeVertexArray->AddVertexBuffer(cubeVertexBuffer);
-	cubeVertexArray->SetIndexBuffer(cubeIndexBuffer);
+
+	//the cubes of the active piece are drawn instanced, every cube is one
+	// translation and color in an instance buffer next to the cube mesh
+	struct CubeInstance {
+		glm::vec3 Translation;
+		glm::vec4 Color;
+	};
+	static_assert(sizeof(CubeInstance) == 7 * sizeof(float),
+		"the instance layout must match CubeInstance");
+	auto instanceBufferLayout = BufferLayout({ {ShaderDataType::Float3, "translation"},
+		{ShaderDataType::Float4, "color"} });
+	//the active piece moves every frame, its cubes are written straight
+	// into a mapped ring of one region per frame in flight
+	auto activeInstanceBuffer = std::make_shared<StreamBuffer>(
+		Pieces::MaxCells * sizeof(CubeInstance));
+	activeInstanceBuffer->SetLayout(instanceBufferLayout);
+	auto activeVertexArray = std::make_shared<VertexArray>();
+	auto cubeIndexBuffer = std::make_shared<IndexBuffer>(cubeTopology.data(), cubeTopology.size());
+	activeVertexArray->AddVertexBuffer(cubeVertexBuffer);
+	activeVertexArray->AddVertexBuffer(activeInstanceBuffer, 1);
+	activeVertexArray->SetIndexBuffer(cubeIndexBuffer);
+
+	//the landed cubes are one mesh without the faces hidden between them,
+	// every chunk in its own region of the vertex buffer. the buffers grow
+	// when the mesh does not fit
+	StackMesher stack(pitWidth, pitHeight, pitDepth, findColor);
+	static_assert(sizeof(StackMesher::Vertex) == 12 * sizeof(float),
+		"the stack layout must match StackMesher::Vertex");
+	auto stackBufferLayout = BufferLayout({ {ShaderDataType::Float3, "position"},
+		{ShaderDataType::Float3, "normals"}, {ShaderDataType::Float2, "edge"},
+		{ShaderDataType::Float4, "color"} });
+	auto stackVertexBuffer = std::make_shared<VertexBuffer>(nullptr, 0, GL_DYNAMIC_DRAW);
+	stackVertexBuffer->SetLayout(stackBufferLayout);
+	auto stackTopology = GeometricTools::QuadTopology(StackMesher::ChunkSize * StackMesher::ChunkSize);
+	auto stackVertexArray = std::make_shared<VertexArray>();
+	auto stackIndexBuffer = std::make_shared<IndexBuffer>(stackTopology.data(), stackTopology.size());
+	stackVertexArray->AddVertexBuffer(stackVertexBuffer);
+	stackVertexArray->SetIndexBuffer(stackIndexBuffer);
+
+	//the game itself, the frames in between its ticks are drawn by
+	// interpolating between the last two ticks
+	FixedTimestep timestep(TickRate);
+	Simulation game(pitWidth, pitHeight, pitDepth, timestep.TicksFromSeconds(FallSeconds),
+		PieceSetFromName(pieceSet));
+	std::vector<Simulation::Input> inputs;	//moves made this tick
+	std::vector<PendingInput> pendingInputs;	//moves pressed but not made yet
+	std::vector<InputEvent> recording;		//every move made, for --record
+	std::unique_ptr<AutoPlayer> player;		//plays the game with --autoplay
+	if (autoplay)
+		player = std::make_unique<AutoPlayer>(threads);
+	bool newPiece = true;					//the active piece was not played yet
 
 	//applying the camera to the cube
 	auto cubeRotation = glm::rotate(glm::mat4(1.0f), glm::radians(0.0f), glm::vec3(1.0f, 0.0f, 0.0f));
-	std::vector<glm::mat4> cubeTranslations;
-	std::vector<glm::vec3> cubeTranslationVectors;
-	glm::vec3 startPos(-0.4f, -0.4f, 1.9f);
-	auto cubeTranslation = glm::translate(glm::mat4(1.0f), startPos);
-	cubeTranslations.push_back(cubeTranslation);
-	cubeTranslationVectors.push_back(startPos);
+	glm::vec3 startPos = space.WorldFromCell(game.GetActivePosition());
 	auto cubeScale = glm::scale(glm::mat4(1.0f), glm::vec3(3.0f, 3.0f, 3.0f));
-	std::vector <glm::mat4> cubeModelMatricies;
-	auto cubeModelMatrix = cubeScale * cubeRotation * cubeTranslation;
-	cubeModelMatricies.push_back(cubeModelMatrix);
+	//the part of the model matrix every cube shares
+	const glm::mat4 cubeBase = cubeScale * cubeRotation;
+	//from the cells of the stack mesh to the world
+	const glm::mat4 stackModel = cubeBase * glm::translate(glm::mat4(1.0f),
+		space.GetOrigin() - glm::vec3(0.5f * space.GetCellSize()))
+		* glm::scale(glm::mat4(1.0f), glm::vec3(space.GetCellSize()));
 	
-	auto cubeViewProjectionMatrix = cam->GetViewProjectionMatrix();
 
 	// Shaders for cube
-	auto cubeShader = std::make_shared<Shader>(Shaders::cubeVertexShader, Shaders::cubeFragmentShader);
-	cubeShader->Bind();
-	cubeShader->UploadUniformMat4x4("u_cubeModMat", cubeModelMatrix);
-	cubeShader->UploadUniformMat4x4("u_cubeViewProjMat", cubeViewProjectionMatrix);
-	cubeShader->UploadUniformFloat("u_diffuseStrength", 0.7);
+	//the handles of the uniforms set while drawing, found once per variant
+	const size_t featureMasks = size_t(1) << Shaders::features.size();
+	std::vector<UniformHandle<int>> cubeFirstDraw(featureMasks);
+	std::vector<UniformHandle<int>> stackFirstDraw(featureMasks);
+	ShaderVariants cubeShaders(Shaders::cubeVertexShader, Shaders::cubeFragmentShader, Shaders::features,
+		[cubeBase, &cubeFirstDraw](Shader& shader, unsigned int mask) {
+			cubeFirstDraw[mask] = shader.Uniform<int>("u_firstDraw");
+			shader.UploadUniformMat4x4("u_cubeModMat", cubeBase);
+			shader.UploadUniformFloat("u_diffuseStrength", 0.7);
+			shader.UploadUniformFloat("u_specularStrenght", 0.5);
+		});
+	//the stack is lit like the cubes
+	ShaderVariants stackShaders(Shaders::stackVertexShader, Shaders::cubeFragmentShader, Shaders::features,
+		[stackModel, &stackFirstDraw](Shader& shader, unsigned int mask) {
+			stackFirstDraw[mask] = shader.Uniform<int>("u_firstDraw");
+			shader.UploadUniformMat4x4("u_stackModMat", stackModel);
+			shader.UploadUniformFloat("u_diffuseStrength", 0.7);
+			shader.UploadUniformFloat("u_specularStrenght", 0.5);
+		});
+
+	//every draw of the scene is a command in one indirect buffer, the counts
+	// of the cubes are updated every frame
+	auto sceneCommands = std::make_shared<IndirectBuffer>();
+	const GLuint pitCommand = sceneCommands->Add(gridVertexArray->GetIndirectCommand());
+	const GLuint activeCommand = sceneCommands->Add(activeVertexArray->GetIndirectCommand(0));
+	//the stack has a command for each chunk, the chunks in the view are
+	// found on the GPU and drawn in one go with as many commands as it found
+	ComputeCuller stackCuller(stack.GetChunkCount(), Shaders::stackCullingBinding);
+	//what the cube shader draws differently for each command, as the
+	// std430 CubeDraw struct in Shaders.h
+	struct CubeDraw {
+		glm::vec4 OutlineColor;
+	};
+	static_assert(sizeof(CubeDraw) == 16, "CubeDraw must match the std430 layout");
+	//the chunks of the stack come after the commands of the scene
+	const GLuint stackDraws = sceneCommands->GetCount();
+	std::vector<CubeDraw> cubeDraws(stackDraws + stack.GetChunkCount(), { glm::vec4(0.0f) });
+	for (size_t chunk = 0; chunk < stack.GetChunkCount(); chunk++)
+		cubeDraws[stackDraws + chunk] = { glm::vec4(1.0f, 1.0f, 0.0f, 1.0f) };
+	cubeDraws[activeCommand] = { glm::vec4(0.0f, 0.0f, 1.0f, 1.0f) };
+	ShaderStorageBuffer cubeDrawBuffer(cubeDraws.data(), cubeDraws.size() * sizeof(CubeDraw),
+		Shaders::cubeDrawsBinding, GL_STATIC_DRAW);
+
+	//the state both shaders share, written once per frame
+	UniformBuffer frameData(UniformBufferLayout({
+		{ShaderDataType::Mat4, "u_viewProjMat"},
+		{ShaderDataType::Float3, "u_lightSourcePosition"},
+		{ShaderDataType::Float, "u_ambientStrength"},
+		{ShaderDataType::Float3, "u_cameraPosition"} }), Shaders::frameDataBinding);
+	const GLuint frameViewProjection = frameData.GetLayout().GetOffset("u_viewProjMat");
+	const GLuint frameLightPosition = frameData.GetLayout().GetOffset("u_lightSourcePosition");
+	const GLuint frameAmbient = frameData.GetLayout().GetOffset("u_ambientStrength");
+	const GLuint frameCameraPosition = frameData.GetLayout().GetOffset("u_cameraPosition");
+
+	//every draw of a frame goes through the queue, which picks the order
+	RenderQueue renderQueue;
+	//the chunks hidden behind the ones in front of them, found by drawing
+	// their boxes after the rest of the frame. the boxes are a bit larger
+	// than the chunks so they are not hidden by the chunks themselves
+	OcclusionCuller occlusion(stack.GetChunkCount(), 0.05f);
+	std::vector<unsigned char> occlusionCandidates(stack.GetChunkCount(), 0);
+	const glm::mat4 cellsFromWorld = glm::inverse(stackModel);
+	unsigned long long occludedChunks = 0;	//added up every frame
+	size_t frameOccludedChunks = 0;			//in the last frame
+	unsigned long long frames = 0;
 
 	//texture manager
 	TextureManager* texMan = TextureManager::GetInstance();
@@ -421,41 +406,35 @@ unsigned int BlockOutApp::Run() const { // Pure virtual function, it must be red
 	texMan->LoadCubeMapRGBA("cube", std::string(TEXTURES_DIR) + std::string("cube_texture.png"), 1);
 
 	// Enables
-	glEnable(GL_DEPTH_TEST);
+	RenderCommands::SetDepthTest(true);
 	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-	glEnable(GL_BLEND);
-	glPolygonOffset(1, 1);
-	glEnable(GL_POLYGON_OFFSET_FILL);
-
-	//adding the normals for the grids to work with lighting
-	std::vector <glm::vec3> normals;
-	normals.push_back(glm::vec3(0.1f, 0.0f, 1.0f));
-	normals.push_back(glm::vec3(0.1f, 0.0f, -1.0f));
-	normals.push_back(glm::vec3(0.0f, 0.1f, 1.0f));
-	normals.push_back(glm::vec3(0.0f, 0.1f, -1.0f));
-	normals.push_back(glm::vec3(1.0f, 0.0f, 1.0f));
-	normals.push_back(glm::vec3(1.0f, 0.0f, -1.0f));
-	normals.push_back(glm::vec3(0.0f, -1.0f, 1.0f));
-	normals.push_back(glm::vec3(0.0f, -1.0f, -1.0f));
-	normals.push_back(glm::vec3(0.0f, 0.0f, -1.0f));
-
-	std::vector <bool> solids;	//keeping track of which cubes are solid
-	solids.push_back(false);//first one is not solid
-	bool pressed = false;	//is a key pressed
-	bool filled = false;		//if a stack is completely filled
+	RenderCommands::SetBlend(true);
+
+	//the game starts with lighting and textures off, those variants are
+	// made before the first frame and the others once they are toggled on
+	gridShaders.Get(0);
+	stackShaders.Get(0);
+	cubeShaders.Get(0);
+
+	if (stats) {
+		const double startupSeconds = std::chrono::duration<double>(
+			std::chrono::steady_clock::now() - startupStart).count();
+		std::cout << "startup: " << startupSeconds * 1000.0 << " ms";
+		if (ProgramCache::IsEnabled()) {
+			std::cout << ", shader programs: " << ProgramCache::GetHits() << " from the cache, "
+				<< ProgramCache::GetMisses() << " compiled";
+		}
+		std::cout << "\n";
+	}
+
+	bool quit = false;		//if Q was pressed
 	bool texture = false;	//if textures should be active
-	int lighting = 0;		//telling the shader if lighting should be active 
-	int textureInt = 0;		//telling the shader if textures should be active
-	//if the day-night cycle should go brighter or darker
-	bool isMorning = false;	
-	float ambient = 0.5f;	//the ambient value sent to the shaders
-	int backwall = 0;		//if the grid sent to the shader is the backwall 
-	glm::vec3 cubePos(-0.4f, -0.4f , 1.9f);	//the active cubes current position
+	int lighting = 0;		//if lighting should be active 
 	//the background color around the tube
 	glm::vec4 backgroundColor(0.5f, 0.5f, 0.5f, 1.0f);
 	//current position of the light
 	glm::vec3 lightPos= cam->GetPosition();
-	lightPos[2] = cubePos.z * 3; //z-axis follows the cube
+	lightPos[2] = startPos.z * 3; //z-axis follows the cube
 
 	//game-loop
 	while (!glfwWindowShouldClose(GLFWApplication::window))
@@ -463,163 +442,220 @@ unsigned int BlockOutApp::Run() const { // Pure virtual function, it must be red
 		glfwPollEvents();
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-	
-		float timer = glfwGetTime(); //timer
-		
-		if (!texture) {
-			textureInt = 0;
-		}
-		else {
-			textureInt = 1;
-		}
-
-		//day night cycle
-		if (isMorning) {
-			ambient += 0.001f;
-			if (ambient > 0.9f) {
-				isMorning = false;
-			}
-		} 
-		else{
-			ambient -= 0.001f;
-			if (ambient < 0.1f) {
-				isMorning = true;
+		//the keys are read once per frame, so Q and the toggles work on
+		// frames without a tick too
+		KeyEvent event;
+		while (keyEvents.Pop(event))
+			keyInput(event, pendingInputs, texture, lighting, quit);
+
+		//runs the simulation ticks that are due since the last frame. the
+		// last one is due the leftover time before now, and a move is handed
+		// to the first tick due at or after its key press, in the order they
+		// were pressed. moves pressed after the last tick wait for the next
+		const int dueTicks = timestep.Advance();
+		const double lastTickTime = glfwGetTime() - timestep.GetAlpha() * timestep.GetTickLength();
+		for (int tick = dueTicks; tick > 0; tick--)
+		{
+			const double tickTime = lastTickTime - (tick - 1) * timestep.GetTickLength();
+			size_t due = 0;
+			inputs.clear();
+			while (due < pendingInputs.size() && pendingInputs[due].time <= tickTime)
+				inputs.push_back(pendingInputs[due++].input);
+			pendingInputs.erase(pendingInputs.begin(), pendingInputs.begin() + due);
+			for (auto input : inputs)
+				game.Apply(input);
+			//the autoplayer drops every new piece as soon as it shows up
+			if (player && newPiece) {
+				player->Play(game, inputs);
+				newPiece = false;
 			}
-		}
-		
-		//binds the grid VA, upload the grid uniforms and draws them	
-		gridVertexArray->Bind();
-		gridShader->Bind();
-		backwall = 0;
-		for (int i = 0; i < grids.size(); i++)
-		{		
-		//changes the pattern of the grid to stop the same color coming twice
-			if(i%8==0|| i % 8 == 1 || i % 8 == 6 || i % 8 == 7) 
-				gridShader->UploadUniformInt("u_pattern", 0);
-			else
-				gridShader->UploadUniformInt("u_pattern", 1);
-			if (i == 8) {
-				backwall = 1;
+			if (!recordFile.empty()) {
+				for (auto input : inputs)
+					recording.push_back({ game.GetTickCount(), input });
 			}
-			gridShader->UploadUniformMat4x4("u_model", grids[i].model);
-			gridShader->UploadUniformInt("u_backWall", backwall);
-			gridShader->UploadUniformFloat3("u_normals", normals[i]);
-			gridShader->UploadUniformFloat3("u_lightSourcePosition", lightPos);
-			gridShader->UploadUniformFloat3("u_cameraPosition", cam->GetPosition());
-			gridShader->UploadUniformFloat("u_specularStrenght", 0.7);
-			gridShader->UploadUniformInt("u_lighting", lighting);
-			gridShader->UploadUniformInt("u_texture", textureInt);
-			gridShader->UploadUniformFloat("u_ambientStrength", ambient);
-			RenderCommands::DrawIndex(gridVertexArray, GL_TRIANGLES);
-		}
 
-		//binds the cube VA, upload the cube uniforms and draws them	
-		cubeShader->Bind();
-		cubeVertexArray->Bind();
-		//process the keyboard input
-		keyInput(window, cubePos, pressed, cubeTranslationVectors, texture, lighting);
-		for (int i = 0; i < cubeModelMatricies.size(); i++)
-		{	
-			//checks if a stack is filled
-			filled =false;
-			for (int j = 1; j < cubeTranslationVectors.size(); j++)
-			{
-				if (floatEqual(cubePos.y, cubeTranslationVectors[j].y) &&
-					floatEqual(cubePos.x, cubeTranslationVectors[j].x) &&
-					cubeTranslationVectors[j].z > 1.71f) {
-					filled = true;
+			Simulation::TickResult result = game.Tick();
+			if (result.respawned)
+				newPiece = true;
+			//the layers the piece landed in are meshed again. full layers
+			// are only removed from those, but every layer above them moves
+			// down and takes the color of its new depth
+			if (result.landedCount > 0) {
+				int first = result.landedCells[0].z;
+				int last = first;
+				for (int c = 1; c < result.landedCount; c++) {
+					first = std::min(first, result.landedCells[c].z);
+					last = std::max(last, result.landedCells[c].z);
 				}
+				stack.Invalidate(first, result.clearedLayers > 0 ? pitDepth - 1 : last);
 			}
-			float bot = bottom(cubePos, cubeTranslationVectors) + 0.001f;
-			//checks if the active cube is at the bottom of the stack and
-			// has not reached the top
-			if (cubePos.z <= bot && cubePos.z<1.81f) {
-				if (!filled) {
-					int last = solids.size() - 1;
-					solids[last] = true; //sets the active cube to solid
-					//saves the active cube translation
-					cubeTranslations[last] = glm::translate(glm::mat4(1.0f),
-																cubePos);
-					//recalculates the modelmatrix
-					cubeModelMatricies[last] = cubeScale * cubeRotation 
-												* cubeTranslations[last];
-					//make a new cube
-					solids.push_back(false);
-					cubeTranslations.push_back(cubeTranslation);
-					cubeModelMatricies.push_back(cubeModelMatrix);
-					cubeTranslationVectors.push_back(cubePos);
-				}
-				//resets the position of the active cube
-				cubePos = startPos;			
+		}
+
+		//the variant of each shader with only the code the toggles turn on
+		const unsigned int features = (lighting ? unsigned(Shaders::Lighting) : 0u)
+			| (texture ? unsigned(Shaders::Texture) : 0u);
+		const std::shared_ptr<Shader>& gridShader = gridShaders.Get(features);
+		const std::shared_ptr<Shader>& stackShader = stackShaders.Get(features);
+		//the active piece is never lit
+		const unsigned int cubeFeatures = features & ~Shaders::Lighting;
+		const std::shared_ptr<Shader>& cubeShader = cubeShaders.Get(cubeFeatures);
+
+		//state drawn this frame, between the last two ticks
+		float alpha = timestep.GetAlpha();
+		glm::vec3 drawCubePos = glm::mix(space.WorldFromCell(game.GetPreviousActivePosition()),
+			space.WorldFromCell(game.GetActivePosition()), alpha);
+		float drawAmbient = glm::mix(game.GetPreviousAmbient(), game.GetAmbient(), alpha);
+		//update the light position to follow the cube
+		lightPos[2] = drawCubePos.z * 3;
+		
+		//the state shared by the grid and the cubes
+		frameData.Set(frameViewProjection, cam->GetViewProjectionMatrix());
+		frameData.Set(frameLightPosition, lightPos);
+		frameData.Set(frameAmbient, drawAmbient);
+		frameData.Set(frameCameraPosition, cam->GetPosition());
+		frameData.Upload();
+		
+		//the pit walls, all of them in one draw
+		const glm::vec3 cameraPosition = cam->GetPosition();
+		const glm::vec3 pitCenter = glm::vec3(gridScale
+			* glm::vec4(0.0f, 0.0f, 0.5f * space.GetSize().z, 1.0f));
+		RenderQueue::Packet pit;
+		pit.Program = gridShader;
+		pit.Vertices = gridVertexArray;
+		pit.Indirect = sceneCommands;
+		pit.FirstCommand = pitCommand;
+		pit.CommandCount = 1;
+		pit.Depth = glm::distance(cameraPosition, pitCenter);
+		renderQueue.Submit(pit);
+
+		//meshes the layers that changed since the last frame and uploads
+		// them, the buffer grows to twice the size when they do not fit
+		if (stack.Update(game.GetPit())) {
+			const std::vector<StackMesher::Vertex>& vertices = stack.GetVertices();
+			const GLsizeiptr vertexSize = sizeof(StackMesher::Vertex);
+			if (static_cast<GLsizeiptr>(stack.GetVertexCount()) * vertexSize > stackVertexBuffer->GetSize()) {
+				stackVertexBuffer->BufferData(nullptr, std::max<GLsizeiptr>(
+					stack.GetVertexCount(), stackVertexBuffer->GetSize() / vertexSize * 2) * vertexSize);
+				stackVertexBuffer->BufferSubData(0, stack.GetVertexCount() * vertexSize, vertices.data());
 			}
-			//the already made solid cubes
-			if (solids[i]) {
-				glm::vec4 color = findColor(cubeTranslationVectors[i+1]);
-				cubeModelMatricies[i] = cubeScale * cubeRotation
-					* cubeTranslations[i];
-				cubeShader->UploadUniformFloat4("u_cubeColor", color);
-				cubeShader->UploadUniformInt("u_texture", textureInt);
-				cubeShader->UploadUniformMat4x4("u_cubeModMat",
-												cubeModelMatricies[i]);
-				//disable blending with lighting to stop the alpha going wild
-				if (lighting == 1)	
-					glDisable(GL_BLEND);
-				else
-					glEnable(GL_BLEND);
-				cubeShader->UploadUniformFloat3("u_lightSourcePosition",
-													lightPos);
-				cubeShader->UploadUniformFloat3("u_cameraPosition",
-													cam->GetPosition());
-				cubeShader->UploadUniformFloat("u_specularStrenght", 0.5);
-				cubeShader->UploadUniformFloat("u_ambientStrength", ambient);
-				cubeShader->UploadUniformInt("u_lighting", lighting);
-				RenderCommands::DrawIndex(cubeVertexArray, GL_TRIANGLES);
-				//draws the border around the cube
-				glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-				cubeShader->UploadUniformFloat4("u_cubeColor",
-											glm::vec4(1.0f, 1.0f, 0.0f, 1.0f));
-				RenderCommands::DrawIndex(cubeVertexArray, GL_TRIANGLES);
+			else if (stack.IsDirty()) {
+				stackVertexBuffer->Bind();
+				stackVertexBuffer->BufferSubData(stack.GetDirtyBegin() * vertexSize,
+					(stack.GetDirtyEnd() - stack.GetDirtyBegin()) * vertexSize,
+					&vertices[stack.GetDirtyBegin()]);
 			}
-			else {			
-				//always enables blending for the active cube since
-				// the lighting does not affect it
-				glEnable(GL_BLEND); 
-				cubeTranslations[i] = glm::translate(glm::mat4(1.0f), cubePos);
-				cubeModelMatricies[i] = cubeScale * cubeRotation
-					* cubeTranslations[i];
-				cubeShader->UploadUniformMat4x4("u_cubeModMat",
-					cubeModelMatricies[i]);
-				cubeShader->UploadUniformInt("u_texture", textureInt);
-				cubeShader->UploadUniformMat4x4("u_cubeViewProjMat",
-					cam->GetViewProjectionMatrix());
-				cubeShader->UploadUniformInt("u_lighting", 0);	
-				cubeShader->UploadUniformFloat4("u_cubeColor",
-					glm::vec4(0.0f, 1.0f, 0.0f, 0.3f));
-				RenderCommands::DrawIndex(cubeVertexArray, GL_TRIANGLES);
-				glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-				cubeShader->UploadUniformFloat4("u_cubeColor",
-					glm::vec4(0.0f, 0.0f, 1.0f, 1.0f));
-				RenderCommands::DrawIndex(cubeVertexArray, GL_TRIANGLES);
-				
-				//update the light position to follow the cube
-				lightPos[2] = cubePos.z * 3;
-				//moves the active cube one section in every 2 seconds
-				if (timer > 2.0f) {
-					cubePos.z -= 0.2f;
-					glfwSetTime(0.0f);
-				}
+			stack.MarkClean();
+			//every chunk starts its quads from index 0 of the shared quads,
+			// the stack array is bound so the regrow stays in its own state
+			if (stack.GetMaxChunkQuads() * 6 > stackIndexBuffer->GetCount()) {
+				stackTopology = GeometricTools::QuadTopology(stack.GetMaxChunkQuads() * 2);
+				stackVertexArray->Bind();
+				stackIndexBuffer->BufferData(stackTopology.data(), stackTopology.size());
 			}
-			glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-			//day-night cycle for the background
-			if (lighting) {
-				glClearColor(backgroundColor[0] * ambient, backgroundColor[1] * ambient,
-					backgroundColor[2] * ambient, backgroundColor[3] * ambient);
+			const BoundingBoxes& bounds = stack.GetChunkBounds();
+			for (size_t chunk = 0; chunk < stack.GetChunkCount(); chunk++) {
+				const GLuint quads = static_cast<GLuint>(stack.GetChunkQuads(chunk));
+				stackCuller.Set(chunk, bounds.GetMin(chunk), bounds.GetMax(chunk),
+					{ quads * 6, 1, 0, static_cast<GLint>(stack.GetChunkFirst(chunk)), 0 });
 			}
 		}
+		//the chunks that were hidden when their boxes were last drawn are
+		// left out on the GPU with the ones outside the view. the planes are
+		// moved into the cells of the mesh so the boxes can stay in cells.
+		// boxes outside the view would come back hidden from their queries,
+		// so only the chunks in it are tested
+		const FrustumPlanes stackPlanes = cam->GetFrustumPlanes().Transformed(stackModel);
+		stackPlanes.TestBoxes(stack.GetChunkBounds(), occlusionCandidates);
+		occlusion.Collect();
+		frameOccludedChunks = 0;
+		for (size_t chunk = 0; chunk < stack.GetChunkCount(); chunk++) {
+			occlusionCandidates[chunk] = occlusionCandidates[chunk] && stack.GetChunkQuads(chunk) > 0;
+			stackCuller.SetEnabled(chunk, occlusion.IsVisible(chunk));
+			frameOccludedChunks += occlusionCandidates[chunk] && !occlusion.IsVisible(chunk);
+		}
+		occludedChunks += frameOccludedChunks;
+		frames++;
+		stackCuller.Cull(stackPlanes);
+		//the already made solid cubes with yellow borders, all of them opaque
+		if (stack.GetQuadCount() > 0) {
+			RenderQueue::Packet landed;
+			landed.Program = stackShader;
+			landed.Vertices = stackVertexArray;
+			landed.Indirect = stackCuller.GetCommands();
+			landed.CommandCount = stackCuller.GetCount();
+			landed.DrawCountBuffer = stackCuller.GetDrawCountBuffer();
+			landed.Depth = glm::distance(cameraPosition, glm::vec3(cubeBase
+				* glm::vec4(space.WorldFromCell(glm::ivec3(pitWidth / 2, pitHeight / 2, 0)), 1.0f)));
+			renderQueue.Submit(landed, { {stackFirstDraw[features], static_cast<int>(stackDraws)} });
+		}
+
+		//the cubes of the active piece, see-through and without lighting
+		// inside an opaque blue border
+		const Pieces::Orientation& activePiece = game.GetActiveOrientation();
+		//only the cubes in the view are written
+		const FrustumPlanes cubePlanes = cam->GetFrustumPlanes().Transformed(cubeBase);
+		const glm::vec3 halfCube(0.5f * space.GetCellSize());
+		auto activeInstances = static_cast<CubeInstance*>(activeInstanceBuffer->BeginFrame());
+		GLuint activeCount = 0;
+		for (int c = 0; c < activePiece.Count; c++)
+		{
+			const Pieces::Offset& offset = activePiece.Cells[c];
+			const glm::vec3 translation = drawCubePos + space.GetCellSize()
+				* glm::vec3(offset.x, offset.y, offset.z);
+			if (!cubePlanes.IsVisible(translation - halfCube, translation + halfCube))
+				continue;
+			activeInstances[activeCount].Translation = translation;
+			activeInstances[activeCount].Color = glm::vec4(0.0f, 1.0f, 0.0f, 0.3f);
+			activeCount++;
+		}
+		sceneCommands->Set(activeCommand, activeVertexArray->GetIndirectCommand(activeCount,
+			static_cast<GLuint>(activeInstanceBuffer->GetOffset() / sizeof(CubeInstance))));
+		RenderQueue::Packet active;
+		active.Program = cubeShader;
+		active.Vertices = activeVertexArray;
+		active.Indirect = sceneCommands;
+		active.FirstCommand = activeCommand;
+		active.CommandCount = 1;
+		active.Depth = glm::distance(cameraPosition,
+			glm::vec3(cubeBase * glm::vec4(drawCubePos, 1.0f)));
+		active.Blend = true;
+
+		//the opaque part of the frame is drawn first so the boxes of the
+		// chunks can be tested against its depth. the see-through active
+		// piece must not hide anything, so it comes after them
+		sceneCommands->Upload();
+		renderQueue.Flush();
+		occlusion.Test(stack.GetChunkBounds(), occlusionCandidates, cam->GetViewProjectionMatrix() * stackModel,
+			glm::vec3(cellsFromWorld * glm::vec4(cameraPosition, 1.0f)));
+		renderQueue.Submit(active, { {cubeFirstDraw[cubeFeatures], static_cast<int>(activeCommand)} });
+		renderQueue.Flush();
+		activeInstanceBuffer->EndFrame();
+
+		//day-night cycle for the background
+		if (lighting) {
+			glClearColor(backgroundColor[0] * drawAmbient, backgroundColor[1] * drawAmbient,
+				backgroundColor[2] * drawAmbient, backgroundColor[3] * drawAmbient);
+		}
 		glfwSwapBuffers(GLFWApplication::window);
-		// Exit the loop if escape is pressed
-		if (glfwGetKey(GLFWApplication::window, GLFW_KEY_Q) == GLFW_PRESS) break;
+		// Exit the loop if Q was pressed
+		if (quit) break;
 	}
 	glfwTerminate();
+	if (!recordFile.empty())
+		Replay::Save(recordFile, recording);
+	if (!stats)
+		return 0;
+	//what the renderer saved over the run, with --stats
+	const RenderCommands::StateStats& stateStats = RenderCommands::GetStateStats();
+	std::cout << "state changes: " << stateStats.issued << " made, "
+		<< stateStats.filtered << " filtered out\n";
+	std::cout << "shader variants built: " << gridShaders.GetVariantCount()
+		+ stackShaders.GetVariantCount() + cubeShaders.GetVariantCount() << "\n";
+	std::cout << "key events dropped: " << droppedKeyEvents << "\n";
+	std::cout << "stream buffer waits: " << activeInstanceBuffer->GetStallCount() << "\n";
+	std::cout << "landed stack: " << stack.GetQuadCount() * 2 << " triangles, "
+		<< stack.GetCubeCount() * 12 << " as separate cubes\n";
+	std::cout << "stack chunks hidden behind others: " << frameOccludedChunks << " in the last frame, "
+		<< (frames > 0 ? static_cast<double>(occludedChunks) / frames : 0.0) << " per frame\n";
 	return 0;
 }
\ No newline at end of file
@@ -17,5 +17,9 @@ public:
 	virtual unsigned int Init(); // Virtual function with defaut behavior
 	// Run function
 	virtual unsigned int Run() const override; // Pure virtual function, it must be redefined
+
+private:
+	// Runs the game logic without a window, see --headless
+	unsigned int RunHeadless() const;
 };
 #endif
@@ -0,0 +1,24 @@
+#include "FixedTimestep.h"
+
+FixedTimestep::FixedTimestep(double tickRate, int maxTicksPerFrame)
+	: TickLength(1.0 / tickRate), MaxTicksPerFrame(maxTicksPerFrame),
+	LastTime(Clock::now()) {
+}
+
+int FixedTimestep::Advance() {
+	Clock::time_point now = Clock::now();
+	Accumulator += std::chrono::duration<double>(now - LastTime).count();
+	LastTime = now;
+
+	int ticks = 0;
+	while (Accumulator >= TickLength && ticks < MaxTicksPerFrame) {
+		Accumulator -= TickLength;
+		ticks++;
+	}
+	//drop the time we could not catch up with
+	if (ticks == MaxTicksPerFrame && Accumulator >= TickLength)
+		Accumulator = 0.0;
+
+	TickCount += ticks;
+	return ticks;
+}
@@ -0,0 +1,43 @@
+#ifndef FIXEDTIMESTEP_H_
+#define FIXEDTIMESTEP_H_
+
+#include <chrono>
+
+// =============================================================================
+// FixedTimestep
+// =============================================================================
+// Splits the time that passed between two frames into simulation ticks of a
+// fixed length. The leftover time stays in an accumulator and is handed to the
+// renderer as an interpolation factor between the last two ticks, so the game
+// runs at the same speed no matter how fast frames are drawn.
+class FixedTimestep
+{
+public:
+	using Clock = std::chrono::steady_clock;
+
+	// tickRate - simulation ticks per second
+	// maxTicksPerFrame - upper limit of ticks run for one frame so a long stall
+	//		(a moved window, a breakpoint) does not make the game run ahead
+	explicit FixedTimestep(double tickRate = 60.0, int maxTicksPerFrame = 8);
+
+	// Reads the clock and returns how many ticks the simulation has to run
+	int Advance();
+
+	// How far the clock is between the last tick and the next one [0,1)
+	inline float GetAlpha() const { return static_cast<float>(Accumulator / TickLength); }
+	// Length of a tick in seconds
+	inline double GetTickLength() const { return TickLength; }
+	// Ticks run since the start
+	inline unsigned long long GetTickCount() const { return TickCount; }
+	// Converts seconds to a whole number of ticks
+	inline int TicksFromSeconds(double seconds) const { return static_cast<int>(seconds / TickLength + 0.5); }
+
+private:
+	double TickLength;
+	int MaxTicksPerFrame;
+	double Accumulator = 0.0;
+	unsigned long long TickCount = 0;
+	Clock::time_point LastTime;
+};
+
+#endif // FIXEDTIMESTEP_H_
@@ -0,0 +1,335 @@
+#include "GameState.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define GAMESTATE_SSE2
+#include <emmintrin.h>
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace {
+	// Number of set bits in a layer
+	inline int popCount(std::uint32_t bits) {
+#if defined(_MSC_VER)
+		return static_cast<int>(__popcnt(bits));
+#elif defined(__GNUC__)
+		return __builtin_popcount(bits);
+#else
+		int count = 0;
+		for (; bits; bits &= bits - 1)
+			count++;
+		return count;
+#endif
+	}
+
+	inline int popCount(std::uint64_t bits) {
+#if defined(_MSC_VER) && defined(_M_X64)
+		return static_cast<int>(__popcnt64(bits));
+#elif defined(__GNUC__)
+		return __builtin_popcountll(bits);
+#else
+		return popCount(static_cast<std::uint32_t>(bits)) +
+			popCount(static_cast<std::uint32_t>(bits >> 32));
+#endif
+	}
+}
+
+PitSpace::PitSpace(int width, int height, int depth) {
+	//one unit across the wider side of the opening, two units deep at most
+	CellSize = 1.0f / std::max({ width, height, (depth + 1) / 2 });
+	Size = glm::vec3(width * CellSize, height * CellSize, depth * CellSize);
+	Origin = glm::vec3((1 - width) * 0.5f * CellSize, (1 - height) * 0.5f * CellSize,
+		0.5f * CellSize);
+}
+
+glm::ivec3 PitSpace::CellFromWorld(const glm::vec3& position) const {
+	glm::vec3 local = (position - Origin) / CellSize;
+	return glm::ivec3(static_cast<int>(std::lround(local.x)),
+		static_cast<int>(std::lround(local.y)),
+		static_cast<int>(std::lround(local.z)));
+}
+
+glm::vec3 PitSpace::WorldFromCell(const glm::ivec3& cell) const {
+	return glm::vec3(Origin.x + cell.x * CellSize,
+		Origin.y + cell.y * CellSize,
+		Origin.z + cell.z * CellSize);
+}
+
+OccupancyGrid::OccupancyGrid(int width, int height, int depth)
+	: Width(width), Height(height), Depth(depth),
+	ChunksX((width + ChunkSize - 1) >> ChunkShift), ChunksY((height + ChunkSize - 1) >> ChunkShift),
+	Slots(static_cast<size_t>(ChunksX) * ChunksY * ((depth + ChunkSize - 1) >> ChunkShift), -1),
+	LayerCounts(depth, 0) {
+}
+
+bool OccupancyGrid::InBounds(int x, int y, int z) const {
+	return x >= 0 && x < Width && y >= 0 && y < Height && z >= 0 && z < Depth;
+}
+
+bool OccupancyGrid::IsSolid(int x, int y, int z) const {
+	if (!InBounds(x, y, z))
+		return true;
+	std::int32_t slot = Slots[ChunkIndex(x, y, z)];
+	if (slot < 0)
+		return false;
+	int bit = BitIndex(x, y, z);
+	return (Chunks[slot].Bits[bit >> 6] >> (bit & 63)) & 1u;
+}
+
+OccupancyGrid::Chunk& OccupancyGrid::Allocate(int index) {
+	std::int32_t& slot = Slots[index];
+	if (slot >= 0)
+		return Chunks[slot];
+	if (!FreeChunks.empty()) {
+		slot = FreeChunks.back();
+		FreeChunks.pop_back();
+	}
+	else {
+		slot = static_cast<std::int32_t>(Chunks.size());
+		Chunks.emplace_back();
+	}
+	Chunks[slot].Bits.fill(0);
+	Chunks[slot].Count = 0;
+	return Chunks[slot];
+}
+
+void OccupancyGrid::Release(int index) {
+	FreeChunks.push_back(Slots[index]);
+	Slots[index] = -1;
+}
+
+void OccupancyGrid::SetSolid(const glm::ivec3& cell, bool solid) {
+	if (!InBounds(cell.x, cell.y, cell.z))
+		return;
+	const int index = ChunkIndex(cell.x, cell.y, cell.z);
+	if (!solid && Slots[index] < 0)
+		return;
+	Chunk& chunk = Allocate(index);
+	const int bit = BitIndex(cell.x, cell.y, cell.z);
+	std::uint64_t& word = chunk.Bits[bit >> 6];
+	const std::uint64_t mask = std::uint64_t(1) << (bit & 63);
+	if (((word & mask) != 0) == solid)
+		return;
+	word ^= mask;
+	const int change = solid ? 1 : -1;
+	chunk.Count += change;
+	LayerCounts[cell.z] += change;
+	if (chunk.Count == 0)
+		Release(index);
+}
+
+void OccupancyGrid::Clear() {
+	std::fill(Slots.begin(), Slots.end(), -1);
+	Chunks.clear();
+	FreeChunks.clear();
+	std::fill(LayerCounts.begin(), LayerCounts.end(), 0);
+}
+
+void OccupancyGrid::CopyLayer(int from, int to, int chunkX, int chunkY) {
+	const int mask = ChunkSize - 1;
+	auto chunkIndex = [&](int z) { return ((z >> ChunkShift) * ChunksY + chunkY) * ChunksX + chunkX; };
+
+	// the layer copied from is empty past the last layer of the pit
+	std::array<std::uint64_t, LayerWords> words{};
+	if (from < Depth && Slots[chunkIndex(from)] >= 0) {
+		const Chunk& source = Chunks[Slots[chunkIndex(from)]];
+		std::copy_n(source.Bits.begin() + (from & mask) * LayerWords, LayerWords, words.begin());
+	}
+
+	const int index = chunkIndex(to);
+	bool empty = std::all_of(words.begin(), words.end(), [](std::uint64_t w) { return w == 0; });
+	if (empty && Slots[index] < 0)
+		return;
+	Chunk& target = Allocate(index);
+	auto layer = target.Bits.begin() + (to & mask) * LayerWords;
+	for (int i = 0; i < LayerWords; i++) {
+		target.Count += popCount(words[i]) - popCount(layer[i]);
+		layer[i] = words[i];
+	}
+	if (target.Count == 0)
+		Release(index);
+}
+
+void OccupancyGrid::RemoveLayer(int z) {
+	if (z < 0 || z >= Depth)
+		return;
+	// every column of chunks moves down one layer at a time, chunks that do
+	// not hold anything on either side are skipped
+	for (int to = z; to < Depth; to++)
+		for (int chunkY = 0; chunkY < ChunksY; chunkY++)
+			for (int chunkX = 0; chunkX < ChunksX; chunkX++)
+				CopyLayer(to + 1, to, chunkX, chunkY);
+	std::copy(LayerCounts.begin() + z + 1, LayerCounts.end(), LayerCounts.begin() + z);
+	LayerCounts.back() = 0;
+}
+
+void OccupancyGrid::AppendCubes(std::vector<glm::ivec3>& cubes) const {
+	const int mask = ChunkSize - 1;
+	for (int z = 0; z < Depth; z++) {
+		if (LayerCounts[z] == 0)
+			continue;
+		for (int chunkY = 0; chunkY < ChunksY; chunkY++) {
+			for (int chunkX = 0; chunkX < ChunksX; chunkX++) {
+				std::int32_t slot = Slots[((z >> ChunkShift) * ChunksY + chunkY) * ChunksX + chunkX];
+				if (slot < 0)
+					continue;
+				const auto layer = Chunks[slot].Bits.begin() + (z & mask) * LayerWords;
+				for (int i = 0; i < LayerWords; i++) {
+					for (std::uint64_t bits = layer[i]; bits; bits &= bits - 1) {
+						int bit = i * 64 + popCount((bits & (~bits + 1)) - 1);
+						cubes.emplace_back((chunkX << ChunkShift) + (bit & mask),
+							(chunkY << ChunkShift) + (bit >> ChunkShift), z);
+					}
+				}
+			}
+		}
+	}
+}
+
+HeightMap::HeightMap(int width, int height)
+	: Width(width), Height(height), Tops(static_cast<size_t>(width) * height, 0) {
+}
+
+int HeightMap::GetTop(int x, int y) const {
+	if (x < 0 || x >= Width || y < 0 || y >= Height)
+		return 0;
+	return Tops[y * Width + x];
+}
+
+void HeightMap::AddCube(const glm::ivec3& cell) {
+	if (cell.x < 0 || cell.x >= Width || cell.y < 0 || cell.y >= Height)
+		return;
+	int& top = Tops[cell.y * Width + cell.x];
+	top = std::max(top, cell.z + 1);
+}
+
+void HeightMap::Clear() {
+	std::fill(Tops.begin(), Tops.end(), 0);
+}
+
+void HeightMap::RemoveLayer(int z, const OccupancyGrid& cells) {
+	for (int y = 0; y < Height; y++) {
+		for (int x = 0; x < Width; x++) {
+			int& top = Tops[y * Width + x];
+			if (top > z + 1) {
+				top--;
+			}
+			else if (top == z + 1) {
+				// the top cube was in the removed layer, look for the next
+				// one under it in the already collapsed grid
+				top = z;
+				while (top > 0 && !cells.IsSolid(x, y, top - 1))
+					top--;
+			}
+		}
+	}
+}
+
+LayerBitboard::LayerBitboard(int width, int height, int depth)
+	: Width(width), Height(height), Layers(depth, 0) {
+	assert((depth == 0 || Fits(width, height)) && "a layer of the pit must fit in 32 bits");
+	FullMask = (width * height >= 32) ? ~Layer(0) : ((Layer(1) << (width * height)) - 1);
+}
+
+bool LayerBitboard::IsSolid(int x, int y, int z) const {
+	if (x < 0 || x >= Width || y < 0 || y >= Height || z < 0 || z >= GetDepth())
+		return true;
+	return (Layers[z] >> (y * Width + x)) & 1u;
+}
+
+void LayerBitboard::SetSolid(const glm::ivec3& cell, bool solid) {
+	if (cell.x < 0 || cell.x >= Width || cell.y < 0 || cell.y >= Height ||
+		cell.z < 0 || cell.z >= GetDepth())
+		return;
+	Layer bit = Layer(1) << (cell.y * Width + cell.x);
+	if (solid)
+		Layers[cell.z] |= bit;
+	else
+		Layers[cell.z] &= ~bit;
+}
+
+int LayerBitboard::CountCubes(int z) const {
+	return popCount(Layers[z]);
+}
+
+int LayerBitboard::CountBits(Layer bits) {
+	return popCount(bits);
+}
+
+std::uint32_t LayerBitboard::FindFullLayers() const {
+	std::uint32_t full = 0;
+	const int depth = std::min(GetDepth(), 32);
+	int z = 0;
+#ifdef GAMESTATE_SSE2
+	// compare four layers against the full mask at a time
+	const __m128i mask = _mm_set1_epi32(static_cast<int>(FullMask));
+	for (; z + 4 <= depth; z += 4) {
+		__m128i layers = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&Layers[z]));
+		int equal = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(layers, mask)));
+		full |= static_cast<std::uint32_t>(equal) << z;
+	}
+#endif
+	for (; z < depth; z++) {
+		if (Layers[z] == FullMask)
+			full |= 1u << z;
+	}
+	return full;
+}
+
+void LayerBitboard::RemoveLayer(int z) {
+	if (z < 0 || z >= GetDepth())
+		return;
+	std::copy(Layers.begin() + z + 1, Layers.end(), Layers.begin() + z);
+	Layers.back() = 0;
+}
+
+void LayerBitboard::Clear() {
+	std::fill(Layers.begin(), Layers.end(), 0);
+}
+
+Pit::Pit(int width, int height, int depth)
+	: Cells(width, height, depth), Tops(width, height),
+	Layers(width, height, LayerBitboard::Fits(width, height) && depth <= 32 ? depth : 0) {
+}
+
+void Pit::AddCube(const glm::ivec3& cell) {
+	Cells.SetSolid(cell);
+	Tops.AddCube(cell);
+	Layers.SetSolid(cell);
+}
+
+void Pit::Clear() {
+	Cells.Clear();
+	Tops.Clear();
+	Layers.Clear();
+}
+
+int Pit::ClearFullLayers() {
+	// packed pits find the full layers by comparing whole layers, larger
+	// pits count the cubes in each layer
+	const std::uint32_t packedFull = IsPacked() ? Layers.FindFullLayers() : 0;
+	const int layerSize = GetWidth() * GetHeight();
+	int removed = 0;
+	// from the top down so the lower full layers keep their index
+	for (int z = GetDepth() - 1; z >= 0; z--) {
+		bool full = IsPacked() ? (packedFull & (1u << z)) != 0 : Cells.CountCubes(z) == layerSize;
+		if (!full)
+			continue;
+		Cells.RemoveLayer(z);
+		Tops.RemoveLayer(z, Cells);
+		Layers.RemoveLayer(z);
+		removed++;
+	}
+	return removed;
+}
+
+std::vector<glm::ivec3> Pit::GetCubes() const {
+	std::vector<glm::ivec3> cubes;
+	Cells.AppendCubes(cubes);
+	return cubes;
+}
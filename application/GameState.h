@@ -0,0 +1,241 @@
+#ifndef GAMESTATE_H_
+#define GAMESTATE_H_
+
+#include "glm/glm.hpp"
+#include "Pieces.h"
+#include <array>
+#include <cstdint>
+#include <vector>
+
+// =============================================================================
+// PitSpace
+// =============================================================================
+// The game logic works on integer cells: x and y go across the opening of the
+// tube and z goes from the back wall (0) towards the camera. The renderer still
+// places cubes in world space, so this converts between the two. The cells are
+// sized so the pit is one world unit across and at most two units deep (before
+// the 3x model scale), the standard 5x5x10 pit has cells of 0.2.
+class PitSpace
+{
+public:
+	PitSpace(int width, int height, int depth);
+
+	glm::ivec3 CellFromWorld(const glm::vec3& position) const;
+	glm::vec3 WorldFromCell(const glm::ivec3& cell) const;
+
+	// size of one cell in world units
+	inline float GetCellSize() const { return CellSize; }
+	// world position of the centre of cell (0,0,0)
+	inline const glm::vec3& GetOrigin() const { return Origin; }
+	// world size of the inside of the pit, the back wall is at z = 0
+	inline const glm::vec3& GetSize() const { return Size; }
+
+private:
+	float CellSize;
+	glm::vec3 Origin;
+	glm::vec3 Size;
+};
+
+// =============================================================================
+// OccupancyGrid
+// =============================================================================
+// Sparse 3D grid with one bit per cell telling if a solid cube is there. The
+// pit is split into chunks of 16x16x16 cells that only take memory once a cube
+// lands in them, so a large and mostly empty pit stays cheap.
+// Lookups are O(1) no matter how many cubes have landed.
+class OccupancyGrid
+{
+public:
+	OccupancyGrid(int width, int height, int depth);
+
+	// Is the cell solid. Cells outside the pit count as solid so that the
+	// walls and the back of the tube block movement like a landed cube would.
+	bool IsSolid(int x, int y, int z) const;
+	bool IsSolid(const glm::ivec3& cell) const { return IsSolid(cell.x, cell.y, cell.z); }
+
+	// Is the cell inside the pit
+	bool InBounds(int x, int y, int z) const;
+
+	// Mark a cell as solid/empty. Cells outside the pit are ignored.
+	void SetSolid(const glm::ivec3& cell, bool solid = true);
+
+	// Remove every cube from the pit
+	void Clear();
+	// Remove a layer and move the layers above it one step down
+	void RemoveLayer(int z);
+
+	// Number of cubes in a layer
+	inline int CountCubes(int z) const { return LayerCounts[z]; }
+	// Adds the cell of every solid cube, layer by layer from the back wall
+	void AppendCubes(std::vector<glm::ivec3>& cubes) const;
+	// Number of chunks that hold cubes
+	inline int GetChunkCount() const { return static_cast<int>(Chunks.size() - FreeChunks.size()); }
+
+	inline int GetWidth() const { return Width; }
+	inline int GetHeight() const { return Height; }
+	inline int GetDepth() const { return Depth; }
+
+private:
+	static constexpr int ChunkShift = 4;
+	static constexpr int ChunkSize = 1 << ChunkShift;
+	// the 16x16 cells of a layer of a chunk are four words
+	static constexpr int LayerWords = ChunkSize * ChunkSize / 64;
+
+	struct Chunk
+	{
+		std::array<std::uint64_t, ChunkSize * LayerWords> Bits;
+		int Count;
+	};
+
+	inline int ChunkIndex(int x, int y, int z) const {
+		return ((z >> ChunkShift) * ChunksY + (y >> ChunkShift)) * ChunksX + (x >> ChunkShift);
+	}
+	inline static int BitIndex(int x, int y, int z) {
+		const int mask = ChunkSize - 1;
+		return (((z & mask) << ChunkShift) + (y & mask)) * ChunkSize + (x & mask);
+	}
+	// Chunk of a slot, made if there is none yet
+	Chunk& Allocate(int index);
+	void Release(int index);
+	// Copies one layer of cells to another within a column of chunks
+	void CopyLayer(int from, int to, int chunkX, int chunkY);
+
+private:
+	int Width;
+	int Height;
+	int Depth;
+	int ChunksX;
+	int ChunksY;
+	std::vector<std::int32_t> Slots;	// chunk of every 16x16x16 block, -1 if empty
+	std::vector<Chunk> Chunks;
+	std::vector<std::int32_t> FreeChunks;
+	std::vector<int> LayerCounts;
+};
+
+// =============================================================================
+// HeightMap
+// =============================================================================
+// Keeps the top of every (x,y) column of the pit, that is the first free cell
+// above the stack. It is updated when a cube lands, so asking where a column
+// ends does not need to look at the cubes in it.
+class HeightMap
+{
+public:
+	HeightMap(int width, int height);
+
+	// First free cell above the stack in the column, 0 for an empty column.
+	// Columns outside the pit are reported as empty.
+	int GetTop(int x, int y) const;
+
+	// Update the column with a cube that landed in the cell
+	void AddCube(const glm::ivec3& cell);
+
+	// Empty every column
+	void Clear();
+	// Update the columns after a layer was removed from the cells
+	void RemoveLayer(int z, const OccupancyGrid& cells);
+
+private:
+	int Width;
+	int Height;
+	std::vector<int> Tops;
+};
+
+// =============================================================================
+// LayerBitboard
+// =============================================================================
+// Packed pit with one bitmask per depth layer, the cell (x,y) of a layer is bit
+// y * width + x. The width times the height of the pit has to fit in the 32 bits
+// of a layer (the standard 5x5 pit takes 25 of them), wider pits are not packed.
+class LayerBitboard
+{
+public:
+	using Layer = std::uint32_t;
+
+	// A bitboard of any other size must have a depth of 0
+	LayerBitboard(int width, int height, int depth);
+
+	// Do the layers of a pit fit in the bits of a layer
+	static bool Fits(int width, int height) { return width * height <= 32; }
+
+	bool IsSolid(int x, int y, int z) const;
+	void SetSolid(const glm::ivec3& cell, bool solid = true);
+
+	// The bits of a layer
+	inline Layer GetLayer(int z) const { return Layers[z]; }
+	// The bits that are set in a full layer
+	inline Layer GetFullMask() const { return FullMask; }
+	// Number of cubes in a layer
+	int CountCubes(int z) const;
+	// Number of set bits in any mask of a layer
+	static int CountBits(Layer bits);
+	// Bitmask with bit z set for every full layer (depth up to 32)
+	std::uint32_t FindFullLayers() const;
+
+	// Remove a layer and move the layers above it one step down
+	void RemoveLayer(int z);
+	// Remove every cube
+	void Clear();
+
+	inline int GetDepth() const { return static_cast<int>(Layers.size()); }
+
+private:
+	int Width;
+	int Height;
+	Layer FullMask;
+	std::vector<Layer> Layers;
+};
+
+// =============================================================================
+// Pit
+// =============================================================================
+// The solid cubes in the tube. All the representations of the stack are kept
+// in sync here so the game only has to tell when a cube lands. Pits of up to
+// 32 layers of up to 32 cells are also kept packed in a bitboard.
+class Pit
+{
+public:
+	// Smallest and largest number of cells along each side. Every piece has
+	// to fit into the pit whichever way it is turned, or it could never be
+	// placed
+	static constexpr int MinSize = Pieces::MaxExtent > 3 ? Pieces::MaxExtent : 3;
+	static constexpr int MaxSize = 256;
+
+	Pit(int width, int height, int depth);
+
+	// Add a solid cube
+	void AddCube(const glm::ivec3& cell);
+	// Remove every cube
+	void Clear();
+	// Remove the full layers and collapse the stack on top of them.
+	// Returns the number of layers that were removed.
+	int ClearFullLayers();
+	// Cells of every solid cube, layer by layer from the back wall
+	std::vector<glm::ivec3> GetCubes() const;
+
+	bool IsSolid(int x, int y, int z) const { return Cells.IsSolid(x, y, z); }
+	bool IsSolid(const glm::ivec3& cell) const { return Cells.IsSolid(cell); }
+
+	// First free cell above the stack in the column
+	int GetColumnTop(int x, int y) const { return Tops.GetTop(x, y); }
+	// A column is full when the stack reaches the starting layer, which is
+	// the last layer of the pit
+	bool IsColumnFull(int x, int y) const { return GetColumnTop(x, y) >= GetDepth() - 1; }
+
+	inline int GetWidth() const { return Cells.GetWidth(); }
+	inline int GetHeight() const { return Cells.GetHeight(); }
+	inline int GetDepth() const { return Cells.GetDepth(); }
+
+	const OccupancyGrid& GetCells() const { return Cells; }
+	const HeightMap& GetHeightMap() const { return Tops; }
+	// The packed layers, with a depth of 0 if the pit is too large for them
+	const LayerBitboard& GetLayers() const { return Layers; }
+	bool IsPacked() const { return Layers.GetDepth() > 0; }
+
+private:
+	OccupancyGrid Cells;
+	HeightMap Tops;
+	LayerBitboard Layers;
+};
+
+#endif // GAMESTATE_H_
@@ -0,0 +1,214 @@
+#ifndef PIECES_H_
+#define PIECES_H_
+
+#include <array>
+#include <cstddef>
+
+// =============================================================================
+// Pieces
+// =============================================================================
+// The polycubes of BlockOut. Every piece is a list of cell offsets from its
+// pivot cell (always the first one, at 0,0,0), and the 24 ways a cube can be
+// turned are applied to them at compile time. Rotating a piece in the game is
+// then just moving to another row of the tables below.
+namespace Pieces {
+
+	// Cell offset from the pivot of a piece
+	struct Offset {
+		int x, y, z;
+	};
+
+	constexpr int MaxCells = 5;
+	constexpr int OrientationCount = 24;
+
+	struct Shape {
+		const char* Name;
+		int Count;
+		std::array<Offset, MaxCells> Cells;
+	};
+
+	// One turned version of a shape with the box around it
+	struct Orientation {
+		int Count;
+		std::array<Offset, MaxCells> Cells;
+		Offset Min;
+		Offset Max;
+	};
+
+	// The shapes, grouped by the sets they first appear in
+	constexpr std::array<Shape, 15> Shapes = { {
+		// Cube (the classic mode of this game)
+		{ "Cube", 1, {{ {0,0,0} }} },
+		// Flat set, everything lies in one layer
+		{ "I3", 3, {{ {0,0,0}, {-1,0,0}, {1,0,0} }} },
+		{ "V3", 3, {{ {0,0,0}, {1,0,0}, {0,1,0} }} },
+		{ "I4", 4, {{ {0,0,0}, {-1,0,0}, {1,0,0}, {2,0,0} }} },
+		{ "L4", 4, {{ {0,0,0}, {-1,0,0}, {1,0,0}, {1,1,0} }} },
+		{ "T4", 4, {{ {0,0,0}, {-1,0,0}, {1,0,0}, {0,1,0} }} },
+		{ "S4", 4, {{ {0,0,0}, {-1,0,0}, {0,1,0}, {1,1,0} }} },
+		{ "O4", 4, {{ {0,0,0}, {1,0,0}, {0,1,0}, {1,1,0} }} },
+		// Basic set adds the 3D tetracubes
+		{ "Branch", 4, {{ {0,0,0}, {1,0,0}, {0,1,0}, {0,0,1} }} },
+		{ "ScrewRight", 4, {{ {0,0,0}, {1,0,0}, {0,1,0}, {0,1,1} }} },
+		{ "ScrewLeft", 4, {{ {0,0,0}, {1,0,0}, {0,1,0}, {1,0,1} }} },
+		// Extended set adds pentacubes
+		{ "X5", 5, {{ {0,0,0}, {-1,0,0}, {1,0,0}, {0,-1,0}, {0,1,0} }} },
+		{ "U5", 5, {{ {0,0,0}, {-1,0,0}, {1,0,0}, {-1,1,0}, {1,1,0} }} },
+		{ "P5", 5, {{ {0,0,0}, {1,0,0}, {0,1,0}, {1,1,0}, {0,2,0} }} },
+		{ "Corner5", 5, {{ {0,0,0}, {1,0,0}, {0,1,0}, {1,1,0}, {0,0,1} }} },
+	} };
+
+	// A set is a range of the shapes
+	enum class Set { Cube, Flat, Basic, Extended };
+
+	struct SetRange {
+		int First;
+		int Count;
+	};
+
+	constexpr SetRange GetSetRange(Set set) {
+		switch (set)
+		{
+		case Set::Cube:     return { 0, 1 };
+		case Set::Flat:     return { 1, 7 };
+		case Set::Basic:    return { 1, 10 };
+		case Set::Extended: return { 1, 14 };
+		}
+		return { 0, 1 };
+	}
+
+	// Offsets tried, in order, when a turned piece does not fit where it is.
+	// The piece starts in the last layer, so it can only be kicked inwards.
+	constexpr std::array<Offset, 11> Kicks = { {
+		{0,0,0}, {1,0,0}, {-1,0,0}, {0,1,0}, {0,-1,0}, {0,0,-1},
+		{2,0,0}, {-2,0,0}, {0,2,0}, {0,-2,0}, {0,0,-2}
+	} };
+
+	// =========================================================================
+	// Compile-time tables
+	// =========================================================================
+	using Matrix = std::array<std::array<int, 3>, 3>;
+
+	constexpr int Determinant(const Matrix& m) {
+		return m[0][0] * (m[1][1] * m[2][2] - m[1][2] * m[2][1])
+			- m[0][1] * (m[1][0] * m[2][2] - m[1][2] * m[2][0])
+			+ m[0][2] * (m[1][0] * m[2][1] - m[1][1] * m[2][0]);
+	}
+
+	constexpr Matrix Multiply(const Matrix& a, const Matrix& b) {
+		Matrix m{};
+		for (int r = 0; r < 3; r++)
+			for (int c = 0; c < 3; c++)
+				for (int k = 0; k < 3; k++)
+					m[r][c] += a[r][k] * b[k][c];
+		return m;
+	}
+
+	constexpr bool Equal(const Matrix& a, const Matrix& b) {
+		for (int r = 0; r < 3; r++)
+			for (int c = 0; c < 3; c++)
+				if (a[r][c] != b[r][c])
+					return false;
+		return true;
+	}
+
+	constexpr Offset Apply(const Matrix& m, const Offset& o) {
+		return { m[0][0] * o.x + m[0][1] * o.y + m[0][2] * o.z,
+				 m[1][0] * o.x + m[1][1] * o.y + m[1][2] * o.z,
+				 m[2][0] * o.x + m[2][1] * o.y + m[2][2] * o.z };
+	}
+
+	// The 24 rotations of a cube are the signed permutation matrices with a
+	// determinant of 1. The identity comes first.
+	constexpr std::array<Matrix, OrientationCount> BuildRotations() {
+		std::array<Matrix, OrientationCount> rotations{};
+		const int permutations[6][3] = { {0,1,2}, {0,2,1}, {1,0,2}, {1,2,0}, {2,0,1}, {2,1,0} };
+		int n = 0;
+		for (int p = 0; p < 6; p++) {
+			for (int signs = 0; signs < 8; signs++) {
+				Matrix m{};
+				for (int r = 0; r < 3; r++)
+					m[r][permutations[p][r]] = (signs >> r) & 1 ? -1 : 1;
+				if (Determinant(m) == 1)
+					rotations[n++] = m;
+			}
+		}
+		return rotations;
+	}
+
+	constexpr std::array<Matrix, OrientationCount> Rotations = BuildRotations();
+
+	// Quarter turns around the x, y and z axes
+	constexpr std::array<Matrix, 3> QuarterTurns = { {
+		{{ {1,0,0}, {0,0,-1}, {0,1,0} }},
+		{{ {0,0,1}, {0,1,0}, {-1,0,0} }},
+		{{ {0,-1,0}, {1,0,0}, {0,0,1} }},
+	} };
+
+	// Turns[orientation][axis] is the orientation after a quarter turn
+	constexpr std::array<std::array<int, 3>, OrientationCount> BuildTurns() {
+		std::array<std::array<int, 3>, OrientationCount> turns{};
+		for (int o = 0; o < OrientationCount; o++)
+			for (int axis = 0; axis < 3; axis++) {
+				Matrix turned = Multiply(QuarterTurns[axis], Rotations[o]);
+				for (int j = 0; j < OrientationCount; j++)
+					if (Equal(turned, Rotations[j]))
+						turns[o][axis] = j;
+			}
+		return turns;
+	}
+
+	constexpr std::array<std::array<int, 3>, OrientationCount> Turns = BuildTurns();
+
+	using OrientationTable = std::array<std::array<Orientation, OrientationCount>, Shapes.size()>;
+
+	constexpr OrientationTable BuildOrientations() {
+		OrientationTable table{};
+		for (std::size_t s = 0; s < Shapes.size(); s++) {
+			for (int o = 0; o < OrientationCount; o++) {
+				Orientation& orientation = table[s][o];
+				orientation.Count = Shapes[s].Count;
+				orientation.Min = { 0, 0, 0 };
+				orientation.Max = { 0, 0, 0 };
+				for (int c = 0; c < Shapes[s].Count; c++) {
+					Offset cell = Apply(Rotations[o], Shapes[s].Cells[c]);
+					orientation.Cells[c] = cell;
+					orientation.Min = { cell.x < orientation.Min.x ? cell.x : orientation.Min.x,
+										cell.y < orientation.Min.y ? cell.y : orientation.Min.y,
+										cell.z < orientation.Min.z ? cell.z : orientation.Min.z };
+					orientation.Max = { cell.x > orientation.Max.x ? cell.x : orientation.Max.x,
+										cell.y > orientation.Max.y ? cell.y : orientation.Max.y,
+										cell.z > orientation.Max.z ? cell.z : orientation.Max.z };
+				}
+			}
+		}
+		return table;
+	}
+
+	// Orientations[shape][orientation]
+	constexpr OrientationTable Orientations = BuildOrientations();
+
+	constexpr int FindMaxExtent() {
+		int extent = 1;
+		for (const auto& orientations : Orientations) {
+			for (const Orientation& orientation : orientations) {
+				const int sizes[3] = { orientation.Max.x - orientation.Min.x + 1,
+					orientation.Max.y - orientation.Min.y + 1, orientation.Max.z - orientation.Min.z + 1 };
+				for (int size : sizes)
+					extent = size > extent ? size : extent;
+			}
+		}
+		return extent;
+	}
+
+	// Most cells any piece spans along one axis, in any orientation. A pit
+	// at least this large on every side has room for every piece.
+	constexpr int MaxExtent = FindMaxExtent();
+
+	static_assert(Determinant(Rotations[0]) == 1 && Rotations[0][0][0] == 1 &&
+		Rotations[0][1][1] == 1 && Rotations[0][2][2] == 1, "the identity must come first");
+	static_assert(Turns[Turns[Turns[Turns[0][0]][0]][0]][0] == 0,
+		"four quarter turns must bring a piece back");
+}
+
+#endif // PIECES_H_
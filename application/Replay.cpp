@@ -0,0 +1,83 @@
+#include "Replay.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace {
+	const Simulation::Input Inputs[] = {
+		Simulation::Input::Up, Simulation::Input::Down, Simulation::Input::Left,
+		Simulation::Input::Right, Simulation::Input::Inwards, Simulation::Input::Drop,
+		Simulation::Input::RotateX, Simulation::Input::RotateY, Simulation::Input::RotateZ };
+}
+
+const char* Replay::InputName(Simulation::Input input) {
+	switch (input)
+	{
+	case Simulation::Input::Up:      return "UP";
+	case Simulation::Input::Down:    return "DOWN";
+	case Simulation::Input::Left:    return "LEFT";
+	case Simulation::Input::Right:   return "RIGHT";
+	case Simulation::Input::Inwards: return "INWARDS";
+	case Simulation::Input::Drop:    return "DROP";
+	case Simulation::Input::RotateX: return "ROTATE_X";
+	case Simulation::Input::RotateY: return "ROTATE_Y";
+	case Simulation::Input::RotateZ: return "ROTATE_Z";
+	}
+	return "";
+}
+
+bool Replay::InputFromName(const std::string& name, Simulation::Input& input) {
+	for (auto candidate : Inputs) {
+		if (name == InputName(candidate)) {
+			input = candidate;
+			return true;
+		}
+	}
+	return false;
+}
+
+bool Replay::Load(const std::string& filePath, std::vector<InputEvent>& events) {
+	std::ifstream file(filePath);
+	if (!file) {
+		std::cerr << "Could not open replay file " << filePath << "\n";
+		return false;
+	}
+
+	events.clear();
+	std::string line;
+	int lineNumber = 0;
+	while (std::getline(file, line)) {
+		lineNumber++;
+		if (line.empty() || line[0] == '#')
+			continue;
+
+		std::istringstream fields(line);
+		InputEvent event;
+		std::string name;
+		if (!(fields >> event.tick >> name) || !InputFromName(name, event.input)) {
+			std::cerr << filePath << ":" << lineNumber << ": bad replay event '"
+				<< line << "'\n";
+			return false;
+		}
+		events.push_back(event);
+	}
+
+	std::stable_sort(events.begin(), events.end(),
+		[](const InputEvent& a, const InputEvent& b) { return a.tick < b.tick; });
+	return true;
+}
+
+bool Replay::Save(const std::string& filePath, const std::vector<InputEvent>& events) {
+	std::ofstream file(filePath);
+	if (!file) {
+		std::cerr << "Could not write replay file " << filePath << "\n";
+		return false;
+	}
+
+	file << "# BlockOut replay: <tick> <input>\n";
+	for (const auto& event : events)
+		file << event.tick << " " << InputName(event.input) << "\n";
+	return static_cast<bool>(file);
+}
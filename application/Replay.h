@@ -0,0 +1,33 @@
+#ifndef REPLAY_H_
+#define REPLAY_H_
+
+#include "Simulation.h"
+#include <string>
+#include <vector>
+
+// An input given to the simulation right before the tick with that number ran
+struct InputEvent
+{
+	unsigned long long tick;
+	Simulation::Input input;
+};
+
+// =============================================================================
+// Replay files
+// =============================================================================
+// Recorded input streams are text files with one event per line:
+//		<tick> <input>
+// where input is one of UP, DOWN, LEFT, RIGHT, INWARDS, DROP, ROTATE_X, ROTATE_Y
+// or ROTATE_Z. Empty lines and lines starting with '#' are skipped.
+namespace Replay
+{
+	// Reads the events of a replay file, sorted by tick
+	bool Load(const std::string& filePath, std::vector<InputEvent>& events);
+	// Writes the events to a replay file
+	bool Save(const std::string& filePath, const std::vector<InputEvent>& events);
+
+	const char* InputName(Simulation::Input input);
+	bool InputFromName(const std::string& name, Simulation::Input& input);
+}
+
+#endif // REPLAY_H_
@@ -1,29 +1,62 @@
 #ifndef SHADERS_H_
 #define SHADERS_H_
 
+#include "ComputeCuller.h"
 #include "string"
+#include "vector"
 
 namespace Shaders {
 
+	//binding point of the FrameData block
+	constexpr unsigned int frameDataBinding = 0;
+	//binding point of the CubeDraws buffer
+	constexpr unsigned int cubeDrawsBinding = 1;
+	//first binding point of the culling of the stack
+	constexpr unsigned int stackCullingBinding = 2;
+	//where the culling leaves the chunk of each command it wrote
+	constexpr unsigned int stackChunksBinding = stackCullingBinding + ComputeCuller::Survivors;
+
+	//the #defines the shaders are built with, feature i is bit i of a
+	// ShaderVariants mask. the code of a feature that is off is left out
+	enum Feature { Lighting = 1 << 0, Texture = 1 << 1 };
+	const std::vector<std::string> features = { "LIGHTING", "TEXTURE" };
+
+	//state every shader shares, written once per frame. the members must be
+	// in the same order as the layout of the uniform buffer in BlockOutApp
+	const std::string frameData =
+		R"(
+		layout(std140, binding = )" + std::to_string(frameDataBinding) + R"() uniform FrameData
+		{
+			mat4 u_viewProjMat;
+			vec3 u_lightSourcePosition;
+			float u_ambientStrength;
+			vec3 u_cameraPosition;
+		};
+		)";
+
+	//the walls of the pit, baked into one mesh with the normal and the
+	// checker parity of every cell in its vertices
 	const std::string vertexShader =
 		R"(
 		#version 460 core
-
-		layout(location = 0) in vec2 position;
-		out vec2 positions;
+		)" + frameData + R"(
+		layout(location = 0) in vec3 position;
+		layout(location = 1) in vec3 normal;
+		layout(location = 2) in vec2 texCoords;
+		layout(location = 3) in float parity;
+		out vec2 vs_texCoords;
 		out vec4 vs_pos;
 		out vec4 vs_normal;
+		flat out float vs_parity;
 
-		uniform mat4 u_viewProjMat;
 		uniform mat4 u_model;
-		uniform vec3 u_normals;
 		void main()
 		{
-
-			vs_normal = normalize(u_model*vec4(u_normals,1.0));
-			vs_pos = u_model*vec4(position,0.0f,1.0);
-			positions = position;
-			gl_Position = u_viewProjMat*u_model*vec4(position,0.0, 1.0);
+			vs_normal = vec4(normalize(mat3(u_model)*normal), 0.0);
+			vs_pos = u_model*vec4(position, 1.0);
+			vs_texCoords = texCoords;
+			vs_parity = parity;
+			gl_Position = u_viewProjMat*vs_pos;
 		}
 		)";
 
@@ -32,77 +65,35 @@ namespace Shaders {
 	const std::string fragmentShader =
 		R"(
 		#version 460 core
-
-		#define M_PI 3.14159265358979323846 
-
-		in vec2 positions;
+		)" + frameData + R"(
+		in vec2 vs_texCoords;
 		in vec4 vs_pos;
 		in vec4 vs_normal;
+		flat in float vs_parity;
 		out vec4 finalColor;
 		out vec4 fragPos;
-		uniform vec2 u_divisions=vec2(0.0);
 		uniform vec3 u_color1=vec3(0.0);
 		uniform vec3 u_color2=vec3(1.0);
-		uniform int u_pattern=0;
-		uniform int u_texture;
 		uniform vec4 u_lightColor = vec4(0.1f,1.0f,0.1f,1.0f);
-		uniform float u_ambientStrength=1.0;
-		uniform vec3 u_lightSourcePosition;
 		uniform float u_diffuseStrength = 0.5;
-		uniform vec3 u_cameraPosition;
 		uniform float u_specularStrenght = 0.5;
-		uniform int u_lighting;
-		uniform int u_backWall;
 
-		
+		#ifdef TEXTURE
 		layout(binding=0) uniform sampler2D u_floorTextureSampler;
+		#endif
 
 		void main()
 		{
+			finalColor = vec4(mix(u_color1, u_color2, vs_parity), 1.0);
+			#ifdef TEXTURE
+			finalColor = mix(finalColor,texture(u_floorTextureSampler, vs_texCoords),0.5);
+			#endif
 
-			bool back = false;
-			if(u_backWall==1){
-				back = true;
-			}
-
-			if(u_pattern==0){
-				if(sin(M_PI*u_divisions.y*(positions.y-0.5))>0)
-				{
-					if(sin(M_PI*u_divisions.x*(positions.x-0.5))>0)
-						finalColor = vec4(u_color1,1.0);
-					else
-						finalColor = vec4(u_color2,1.0);
-				}
-				else
-				{
-					if(sin(M_PI*u_divisions.y*(positions.x-0.5))>0)
-						finalColor = vec4(u_color2,1.0);
-					else
-						finalColor = vec4(u_color1,1.0);
-				}
-			}
-			else{
-				if(sin(M_PI*u_divisions.y*(positions.y-0.5))>0)
-				{
-					if(sin(M_PI*u_divisions.x*(positions.x-0.5))>0)
-						finalColor = vec4(u_color2,1.0);
-					else
-						finalColor = vec4(u_color1,1.0);
-				}
-				else
-				{
-					if(sin(M_PI*u_divisions.y*(positions.x-0.5))>0)
-						finalColor = vec4(u_color1,1.0);
-					else
-						finalColor = vec4(u_color2,1.0);
-				}
-			}
+			fragPos = vs_pos;
 
+			#ifdef LIGHTING
 			//diffuse illumination
 			vec3 lightDirection = normalize(vec3(u_lightSourcePosition - vs_pos.xyz));
-			if(back){
-				lightDirection = -lightDirection;
-			}
 			float diffuseStrength = max(dot(lightDirection, vs_normal.xyz), 0.0f)*u_diffuseStrength;
 			
 			//Specualar illumination
@@ -110,69 +101,146 @@ namespace Shaders {
 			vec3 observerDirection = normalize(u_cameraPosition - vs_pos.xyz);
 			float specFactor = pow(max(dot(observerDirection, reflectedLight), 0.0), 15);
 			float specular = specFactor * u_specularStrenght;
-			
-			if(u_texture == 1)
-				finalColor = mix(finalColor,texture(u_floorTextureSampler, positions),0.5);
-
-			fragPos = vs_pos;
 
-			if(u_lighting==1){
-				finalColor *= u_ambientStrength + diffuseStrength + specular;
-			}
+			finalColor *= u_ambientStrength + diffuseStrength + specular;
+			#endif
 		}
 		)";
 	const std::string cubeVertexShader =
 		R"(
 		#version 460 core
+		)" + frameData + R"(
 
 		layout(location = 0) in vec3 position;
 		layout(location = 1) in vec3 normals;
+		layout(location = 2) in vec2 edge;	//where the vertex is on its face
+		//one of each for every cube drawn
+		layout(location = 3) in vec3 instanceTranslation;
+		layout(location = 4) in vec4 instanceColor;
 		
-		out vec3 vs_texPos;
+		flat out vec3 vs_faceNormal;
 		out vec4 vs_normal;
 		out vec4 vs_pos;
+		out vec4 vs_color;
+		out vec2 vs_edge;
+		flat out int vs_draw;
 
-		uniform mat4 u_cubeViewProjMat;
-		uniform mat4 u_cubeModMat;
+		uniform mat4 u_cubeModMat;	//the part of the model matrix every cube shares
+		uniform int u_firstDraw = 0;	//the command the multi-draw starts at
 
 		void main(){
-			vs_texPos = position;
-			vs_normal = normalize(u_cubeModMat*vec4(normals,1.0));
-			vs_pos = u_cubeModMat*vec4(position,1.0);
-			gl_Position = u_cubeViewProjMat*u_cubeModMat*vec4(position, 1.0);
+			//the shared matrix moved by the translation of the cube
+			mat4 model = u_cubeModMat;
+			model[3] = u_cubeModMat*vec4(instanceTranslation, 1.0);
+			vs_faceNormal = normals;
+			vs_normal = normalize(model*vec4(normals,1.0));
+			vs_pos = model*vec4(position,1.0);
+			vs_color = instanceColor;
+			vs_edge = edge;
+			vs_draw = u_firstDraw + gl_DrawID;
+			gl_Position = u_viewProjMat*vs_pos;
 
 		}
 		)";
 
+	//the landed cubes as one mesh, drawn with the cube fragment shader
+	const std::string stackVertexShader =
+		R"(
+		#version 460 core
+		)" + frameData + R"(
+
+		layout(location = 0) in vec3 position;	//in cells, the edges of the cubes are whole numbers
+		layout(location = 1) in vec3 normals;
+		layout(location = 2) in vec2 edge;		//where the vertex is on its face, in cells
+		layout(location = 3) in vec4 color;
+
+		flat out vec3 vs_faceNormal;
+		out vec4 vs_normal;
+		out vec4 vs_pos;
+		out vec4 vs_color;
+		out vec2 vs_edge;
+		flat out int vs_draw;
+
+		//the chunk of every command, written by the culling on the GPU
+		layout(std430, binding = )" + std::to_string(stackChunksBinding) + R"() readonly buffer StackChunks
+		{
+			uint u_stackChunks[];
+		};
+
+		uniform mat4 u_stackModMat;		//from cells to the world
+		uniform int u_firstDraw = 0;	//the CubeDraw of the first chunk
+
+		void main(){
+			vs_faceNormal = normals;
+			vs_normal = normalize(u_stackModMat*vec4(normals,0.0));
+			vs_pos = u_stackModMat*vec4(position,1.0);
+			vs_color = color;
+			vs_edge = edge;
+			vs_draw = u_firstDraw + int(u_stackChunks[gl_DrawID]);
+			gl_Position = u_viewProjMat*vs_pos;
+		}
+		)";
+
 	const std::string cubeFragmentShader =
 		R"(
 		#version 460 core
+		)" + frameData + R"(
 		
 		in vec4 vs_pos;
 		in vec4 vs_normal;
-		in vec3 vs_texPos;
+		flat in vec3 vs_faceNormal;	//before the model matrix
+		in vec4 vs_color;
+		in vec2 vs_edge;
+		flat in int vs_draw;
 		
 		out vec4 finalColor;
 		out vec4 fragPos;
 
-		uniform vec4 u_cubeColor = vec4(0.0f,0.0f,1.0f,1.0f);
-		uniform int u_texture=0;
+		//what is drawn differently in each draw command, by its index in
+		// the indirect buffer or by the chunk of the stack it draws
+		struct CubeDraw
+		{
+			vec4 outlineColor;
+		};
+		layout(std430, binding = )" + std::to_string(cubeDrawsBinding) + R"() readonly buffer CubeDraws
+		{
+			CubeDraw u_cubeDraws[];
+		};
+
+		uniform float u_outlineWidth = 1.5;	//in pixels
 		uniform vec4 u_lightColor = vec4(0.1f,1.0f,0.1f,1.0f);
-		uniform float u_ambientStrength=1.0;
-		uniform vec3 u_lightSourcePosition;
 		uniform float u_diffuseStrength = 0.5;
-		uniform vec3 u_cameraPosition;
 		uniform float u_specularStrenght = 0.5;
-		uniform int u_lighting;
 
+		#ifdef TEXTURE
 		layout(binding=1) uniform samplerCube u_cubeTextureSampler;
+		#endif
 
 		void main(){
-			finalColor = u_cubeColor;
-			if(u_texture==1)
-				finalColor = mix(u_cubeColor,texture(u_cubeTextureSampler, vs_texPos),0.5);
+			//the border is drawn where the fragment is close to an edge
+			// of its cube, measured in pixels so it is as thin far away.
+			// merged faces go across several cubes, only the part of the
+			// edge coordinates inside one cube counts
+			vec2 onFace = fract(vs_edge);
+			vec2 toEdge = min(onFace, 1.0 - onFace) / fwidth(vs_edge);
+			float outline = 1.0 - clamp(min(toEdge.x, toEdge.y) - u_outlineWidth + 0.5, 0.0, 1.0);
+			vec4 cubeColor = mix(vs_color, u_cubeDraws[vs_draw].outlineColor, outline);
+			finalColor = cubeColor;
+			#ifdef TEXTURE
+			//the cube map is looked up from the centre of the cube. the
+			// normals of the cube mesh are scaled with the cells, only
+			// their sign tells the face
+			onFace -= 0.5;
+			vec3 faceSide = 0.5*sign(vs_faceNormal);
+			vec3 texPos = faceSide.x != 0.0 ? vec3(faceSide.x, onFace)
+				: faceSide.y != 0.0 ? vec3(onFace.x, faceSide.y, onFace.y)
+				: vec3(onFace, faceSide.z);
+			finalColor = mix(cubeColor,texture(u_cubeTextureSampler, texPos),0.5);
+			#endif
 
-			
+			fragPos = vs_pos;
+
+			#ifdef LIGHTING
 			//diffuse illumination
 			vec3 lightDirection = normalize(vec3(u_lightSourcePosition - vs_pos.xyz));
 			float diffuseStrength = max(dot(lightDirection, vs_normal.xyz), 0.0f)*u_diffuseStrength;
@@ -183,10 +251,8 @@ namespace Shaders {
 			float specFactor = pow(max(dot(observerDirection, reflectedLight), 0.0), 15);
 			float specular = specFactor * u_specularStrenght;
 
-			fragPos = vs_pos;
-
-			if(u_lighting==1)
-				finalColor *= u_ambientStrength + diffuseStrength + specular;
+			finalColor *= u_ambientStrength + diffuseStrength + specular;
+			#endif
 		}
 		
 		)";
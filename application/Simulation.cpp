@@ -0,0 +1,178 @@
+#include "Simulation.h"
+
+#include <algorithm>
+
+namespace {
+	inline glm::ivec3 toCell(const Pieces::Offset& offset) {
+		return glm::ivec3(offset.x, offset.y, offset.z);
+	}
+}
+
+Simulation::Simulation(int width, int height, int depth, int ticksPerFall,
+	Pieces::Set pieces, std::uint32_t seed)
+	: Stack(width, height, depth), TicksPerFall(ticksPerFall),
+	PieceRange(Pieces::GetSetRange(pieces)), Seed(seed ? seed : 1), RandomState(Seed) {
+	Respawn();
+}
+
+bool Simulation::Fits(int shape, int orientation, const glm::ivec3& position) const {
+	const Pieces::Orientation& piece = Pieces::Orientations[shape][orientation];
+	for (int i = 0; i < piece.Count; i++) {
+		if (Stack.IsSolid(position + toCell(piece.Cells[i])))
+			return false;
+	}
+	return true;
+}
+
+bool Simulation::TryMove(const glm::ivec3& offset) {
+	glm::ivec3 target = Active + offset;
+	if (!Fits(ActiveShape, ActiveOrientation, target))
+		return false;
+	//moves from the player are shown right away, so the position of the
+	// last tick moves along with the piece
+	Active = target;
+	PreviousActive = PreviousActive + offset;
+	return true;
+}
+
+bool Simulation::FindTurn(int shape, int orientation, const glm::ivec3& position, int axis,
+	glm::ivec3& turnedPosition) const {
+	int turned = Pieces::Turns[orientation][axis];
+	for (const auto& kick : Pieces::Kicks) {
+		glm::ivec3 target = position + toCell(kick);
+		if (Fits(shape, turned, target)) {
+			turnedPosition = target;
+			return true;
+		}
+	}
+	return false;
+}
+
+bool Simulation::TryRotate(int axis) {
+	glm::ivec3 target;
+	if (!FindTurn(ActiveShape, ActiveOrientation, Active, axis, target))
+		return false;
+	ActiveOrientation = Pieces::Turns[ActiveOrientation][axis];
+	PreviousActive = PreviousActive + (target - Active);
+	Active = target;
+	return true;
+}
+
+int Simulation::DropDistance(int shape, int orientation, const glm::ivec3& position) const {
+	const Pieces::Orientation& piece = Pieces::Orientations[shape][orientation];
+	//the height map answers it as long as every cube of the piece is above
+	// the stack in its column
+	int distance = position.z + piece.Min.z;
+	for (int i = 0; i < piece.Count; i++) {
+		glm::ivec3 cell = position + toCell(piece.Cells[i]);
+		int top = Stack.GetColumnTop(cell.x, cell.y);
+		if (cell.z < top) {
+			//under an overhang, step inwards until it hits something
+			distance = 0;
+			while (Fits(shape, orientation, position - glm::ivec3(0, 0, distance + 1)))
+				distance++;
+			return distance;
+		}
+		distance = std::min(distance, cell.z - top);
+	}
+	return distance;
+}
+
+bool Simulation::Apply(Input input) {
+	switch (input)
+	{
+	case Input::Up:      return TryMove(glm::ivec3(0, 1, 0));
+	case Input::Down:    return TryMove(glm::ivec3(0, -1, 0));
+	case Input::Left:    return TryMove(glm::ivec3(-1, 0, 0));
+	case Input::Right:   return TryMove(glm::ivec3(1, 0, 0));
+	case Input::Inwards: return TryMove(glm::ivec3(0, 0, -1));
+	case Input::Drop: {
+		int distance = DropDistance();
+		return distance > 0 && TryMove(glm::ivec3(0, 0, -distance));
+	}
+	case Input::RotateX: return TryRotate(0);
+	case Input::RotateY: return TryRotate(1);
+	case Input::RotateZ: return TryRotate(2);
+	}
+	return false;
+}
+
+void Simulation::Lock(TickResult& result) {
+	const Pieces::Orientation& piece = GetActiveOrientation();
+	for (int i = 0; i < piece.Count; i++) {
+		glm::ivec3 cell = Active + toCell(piece.Cells[i]);
+		Stack.AddCube(cell);
+		result.landedCells[result.landedCount++] = cell;
+	}
+	result.clearedLayers = Stack.ClearFullLayers();
+	LandedCount += piece.Count;
+	ClearedLayerCount += result.clearedLayers;
+}
+
+Simulation::TickResult Simulation::Tick() {
+	TickResult result;
+	PreviousActive = Active;
+	PreviousAmbient = Ambient;
+	TickCount++;
+
+	//day night cycle
+	if (IsMorning) {
+		Ambient += 0.001f;
+		if (Ambient > 0.9f)
+			IsMorning = false;
+	}
+	else {
+		Ambient -= 0.001f;
+		if (Ambient < 0.1f)
+			IsMorning = true;
+	}
+
+	//checks if the active piece rests on the stack or the back wall
+	if (!Fits(ActiveShape, ActiveOrientation, Active - glm::ivec3(0, 0, 1))) {
+		//the stack is filled if the piece can not leave the starting layer,
+		// then it is dropped without becoming solid
+		if (Active.z + GetActiveOrientation().Max.z < Stack.GetDepth() - 1)
+			Lock(result);
+		Respawn();
+		result.respawned = true;
+	}
+
+	//moves the active piece one section inwards every fall period
+	if (++FallTicks >= TicksPerFall) {
+		//not through TryMove, the fall is interpolated while drawing
+		if (Fits(ActiveShape, ActiveOrientation, Active - glm::ivec3(0, 0, 1)))
+			Active.z--;
+		FallTicks = 0;
+	}
+	return result;
+}
+
+void Simulation::Reset() {
+	Stack.Clear();
+	IsMorning = false;
+	Ambient = PreviousAmbient = 0.5f;
+	TickCount = LandedCount = ClearedLayerCount = 0;
+	RandomState = Seed;
+	Respawn();
+}
+
+void Simulation::Reset(std::uint32_t seed) {
+	Seed = seed ? seed : 1;
+	Reset();
+}
+
+void Simulation::Respawn() {
+	//xorshift32, the same seed always gives the same pieces
+	RandomState ^= RandomState << 13;
+	RandomState ^= RandomState >> 17;
+	RandomState ^= RandomState << 5;
+	ActiveShape = PieceRange.First + static_cast<int>(RandomState % PieceRange.Count);
+	ActiveOrientation = 0;
+
+	//the piece starts in the corner of the starting layer
+	const Pieces::Orientation& piece = GetActiveOrientation();
+	Active = glm::ivec3(-piece.Min.x, -piece.Min.y, Stack.GetDepth() - 1 - piece.Max.z);
+	//no interpolation of the jump back to the start
+	PreviousActive = Active;
+	FallTicks = 0;
+}
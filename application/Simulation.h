@@ -0,0 +1,115 @@
+#ifndef SIMULATION_H_
+#define SIMULATION_H_
+
+#include "GameState.h"
+#include "Pieces.h"
+
+#include <array>
+#include <cstdint>
+
+// =============================================================================
+// Simulation
+// =============================================================================
+// The rules of the game without any window or GL: moving and turning the
+// active piece, collision, landing, clearing layers and spawning the next
+// piece. The game advances in fixed ticks and is fully deterministic, so the
+// same inputs on the same ticks always give the same pit.
+class Simulation
+{
+public:
+	// Everything the player can do to the active piece
+	enum class Input { Up, Down, Left, Right, Inwards, Drop, RotateX, RotateY, RotateZ };
+
+	// What happened during a tick, so the renderer can follow the pit
+	struct TickResult
+	{
+		int landedCount = 0;		// cubes of the active piece that became solid
+		std::array<glm::ivec3, Pieces::MaxCells> landedCells;	// where they landed
+		int clearedLayers = 0;		// full layers removed after the landing
+		bool respawned = false;		// a new active piece is at the start
+	};
+
+public:
+	// width, height, depth - size of the pit in cells
+	// ticksPerFall - ticks between each time the active piece moves inwards
+	// pieces - the pieces that are handed out
+	// seed - start of the random sequence of pieces
+	Simulation(int width, int height, int depth, int ticksPerFall,
+		Pieces::Set pieces = Pieces::Set::Basic, std::uint32_t seed = 1);
+
+	// Applies an input to the active piece right away.
+	// Returns true if the piece moved or turned.
+	bool Apply(Input input);
+
+	// Runs one tick of the game
+	TickResult Tick();
+
+	// Starts over with an empty pit
+	void Reset();
+	// Starts over with an empty pit and another sequence of pieces
+	void Reset(std::uint32_t seed);
+
+	// Does a piece fit in the pit at the position
+	bool Fits(int shape, int orientation, const glm::ivec3& position) const;
+	// How many cells a piece that fits at the position can fall straight inwards
+	int DropDistance(int shape, int orientation, const glm::ivec3& position) const;
+	// Where a piece ends up when turned a quarter around an axis, kicked to the
+	// closest place it fits. Returns false if it does not fit anywhere.
+	bool FindTurn(int shape, int orientation, const glm::ivec3& position, int axis,
+		glm::ivec3& turnedPosition) const;
+
+	const Pit& GetPit() const { return Stack; }
+
+	// The active piece: shape, orientation and the cell of its pivot now and
+	// at the start of the last tick
+	int GetActiveShape() const { return ActiveShape; }
+	int GetActiveOrientationIndex() const { return ActiveOrientation; }
+	const Pieces::Orientation& GetActiveOrientation() const {
+		return Pieces::Orientations[ActiveShape][ActiveOrientation];
+	}
+	const glm::ivec3& GetActivePosition() const { return Active; }
+	const glm::ivec3& GetPreviousActivePosition() const { return PreviousActive; }
+
+	// Day-night ambient light now and at the start of the last tick
+	float GetAmbient() const { return Ambient; }
+	float GetPreviousAmbient() const { return PreviousAmbient; }
+
+	unsigned long long GetTickCount() const { return TickCount; }
+	unsigned long long GetLandedCount() const { return LandedCount; }
+	unsigned long long GetClearedLayerCount() const { return ClearedLayerCount; }
+
+private:
+	// Moves the active piece by an offset if it fits there
+	bool TryMove(const glm::ivec3& offset);
+	// Turns the active piece a quarter around an axis, kicking it to the
+	// closest place it fits
+	bool TryRotate(int axis);
+	// How many cells the active piece can fall straight inwards
+	int DropDistance() const { return DropDistance(ActiveShape, ActiveOrientation, Active); }
+	// Makes the active piece solid and removes the full layers
+	void Lock(TickResult& result);
+	void Respawn();
+
+private:
+	Pit Stack;
+	int TicksPerFall;
+	Pieces::SetRange PieceRange;
+	std::uint32_t Seed;
+	std::uint32_t RandomState;
+
+	int ActiveShape = 0;
+	int ActiveOrientation = 0;
+	glm::ivec3 Active;
+	glm::ivec3 PreviousActive;
+	int FallTicks = 0;
+
+	bool IsMorning = false;
+	float Ambient = 0.5f;
+	float PreviousAmbient = 0.5f;
+
+	unsigned long long TickCount = 0;
+	unsigned long long LandedCount = 0;
+	unsigned long long ClearedLayerCount = 0;
+};
+
+#endif // SIMULATION_H_
@@ -0,0 +1,185 @@
+#include "StackMesher.h"
+
+#include <algorithm>
+
+namespace {
+	// Vertices a new region is made with at least, regions grow in powers of two
+	constexpr size_t MinRegionSize = 64;
+}
+
+StackMesher::StackMesher(int width, int height, int depth, ColorFunction color)
+	: Color(color), Width(width), Height(height),
+	ChunksX((width + ChunkSize - 1) / ChunkSize), ChunksY((height + ChunkSize - 1) / ChunkSize),
+	Chunks(static_cast<size_t>(ChunksX) * ChunksY * depth),
+	Changed(Chunks.size(), false) {
+	for (size_t chunk = 0; chunk < Chunks.size(); chunk++)
+		Bounds.Add(glm::vec3(0.0f), glm::vec3(0.0f));
+}
+
+void StackMesher::Invalidate(int first, int last) {
+	const int layers = static_cast<int>(Chunks.size()) / (ChunksX * ChunksY);
+	first = std::max(first - 1, 0);
+	last = std::min(last + 1, layers - 1);
+	std::fill(Changed.begin() + first * ChunksX * ChunksY,
+		Changed.begin() + (last + 1) * ChunksX * ChunksY, true);
+}
+
+bool StackMesher::Update(const Pit& pit) {
+	bool meshed = false;
+	for (size_t chunk = 0; chunk < Chunks.size(); chunk++) {
+		if (!Changed[chunk])
+			continue;
+		MeshChunk(pit, chunk);
+		Place(chunk);
+		Changed[chunk] = false;
+		meshed = true;
+	}
+	if (meshed) {
+		MaxChunkQuads = 0;
+		for (const Region& region : Chunks)
+			MaxChunkQuads = std::max(MaxChunkQuads, region.Quads);
+	}
+	return meshed;
+}
+
+void StackMesher::MeshChunk(const Pit& pit, size_t chunk) {
+	const int z = static_cast<int>(chunk / (ChunksX * ChunksY));
+	const int x0 = static_cast<int>(chunk % ChunksX) * ChunkSize;
+	const int y0 = static_cast<int>(chunk / ChunksX % ChunksY) * ChunkSize;
+	const int width = std::min(ChunkSize, Width - x0);
+	const int height = std::min(ChunkSize, Height - y0);
+	Scratch.clear();
+	CubeCount -= Chunks[chunk].Cubes;
+	Chunks[chunk].Cubes = 0;
+	for (int y = y0; y < y0 + height; y++) {
+		for (int x = x0; x < x0 + width; x++)
+			Chunks[chunk].Cubes += pit.IsSolid(x, y, z);
+	}
+	CubeCount += Chunks[chunk].Cubes;
+	if (Chunks[chunk].Cubes == 0)
+		return;
+
+	const glm::vec4 color = Color(z);
+	//a face is only kept if the cell it looks into is empty. cells outside
+	// the pit count as solid, the walls hide the faces against them, but
+	// nothing is in front of the last layer
+	for (int side = -1; side <= 1; side += 2) {
+		Mask.assign(static_cast<size_t>(width) * height, 0);
+		for (int y = 0; y < height; y++) {
+			for (int x = 0; x < width; x++) {
+				const bool covered = z + side < pit.GetDepth() && pit.IsSolid(x0 + x, y0 + y, z + side);
+				Mask[y * width + x] = pit.IsSolid(x0 + x, y0 + y, z) && !covered;
+			}
+		}
+		MergeFaces(Mask, width, height, 2, side, glm::ivec3(x0, y0, z), color);
+
+		//the sides of the cubes are one cell high, so they only merge along
+		// the rows and columns of the layer
+		for (int x = x0; x < x0 + width; x++) {
+			Mask.assign(height, 0);
+			for (int y = 0; y < height; y++)
+				Mask[y] = pit.IsSolid(x, y0 + y, z) && !pit.IsSolid(x + side, y0 + y, z);
+			MergeFaces(Mask, height, 1, 0, side, glm::ivec3(x, y0, z), color);
+		}
+		for (int y = y0; y < y0 + height; y++) {
+			Mask.assign(width, 0);
+			for (int x = 0; x < width; x++)
+				Mask[x] = pit.IsSolid(x0 + x, y, z) && !pit.IsSolid(x0 + x, y + side, z);
+			MergeFaces(Mask, width, 1, 1, side, glm::ivec3(x0, y, z), color);
+		}
+	}
+}
+
+void StackMesher::MergeFaces(std::vector<char>& mask, int sizeU, int sizeV, int axis, int side,
+	const glm::ivec3& origin, const glm::vec4& color) {
+	//the two axes along the face in the same order as the edges of the cube mesh
+	const int axisU = axis == 0 ? 1 : 0;
+	const int axisV = axis == 2 ? 1 : 2;
+	//the corners go counter-clockwise seen from the side the face looks to
+	const bool flip = (axis == 1) != (side < 0);
+	const glm::vec2 corners[4] = { glm::vec2(0.0f, 0.0f),
+		flip ? glm::vec2(0.0f, 1.0f) : glm::vec2(1.0f, 0.0f), glm::vec2(1.0f, 1.0f),
+		flip ? glm::vec2(1.0f, 0.0f) : glm::vec2(0.0f, 1.0f) };
+	glm::vec3 normal(0.0f);
+	normal[axis] = static_cast<float>(side);
+
+	for (int v = 0; v < sizeV; v++) {
+		for (int u = 0; u < sizeU; u++) {
+			if (!mask[v * sizeU + u])
+				continue;
+			//as wide as the row goes, then as high as the whole width goes
+			int du = 1;
+			while (u + du < sizeU && mask[v * sizeU + u + du])
+				du++;
+			int dv = 1;
+			while (v + dv < sizeV && std::all_of(mask.begin() + (v + dv) * sizeU + u,
+				mask.begin() + (v + dv) * sizeU + u + du, [](char m) { return m != 0; }))
+				dv++;
+			for (int i = 0; i < dv; i++)
+				std::fill_n(mask.begin() + (v + i) * sizeU + u, du, 0);
+
+			for (const glm::vec2& corner : corners) {
+				glm::vec3 position;
+				position[axis] = static_cast<float>(origin[axis] + (side > 0 ? 1 : 0));
+				position[axisU] = origin[axisU] + u + corner.x * du;
+				position[axisV] = origin[axisV] + v + corner.y * dv;
+				Scratch.push_back({ position, normal,
+					glm::vec2(position[axisU], position[axisV]), color });
+			}
+		}
+	}
+}
+
+void StackMesher::Place(size_t chunk) {
+	Region& region = Chunks[chunk];
+	const size_t count = Scratch.size();
+	if (count > region.Capacity) {
+		//the old region is left for another chunk, the smallest free region
+		// that is large enough is taken before the array grows
+		if (region.Capacity > 0)
+			FreeRegions.push_back(region);
+		auto best = FreeRegions.end();
+		for (auto it = FreeRegions.begin(); it != FreeRegions.end(); ++it) {
+			if (it->Capacity >= count && (best == FreeRegions.end() || it->Capacity < best->Capacity))
+				best = it;
+		}
+		if (best != FreeRegions.end()) {
+			region.First = best->First;
+			region.Capacity = best->Capacity;
+			FreeRegions.erase(best);
+		}
+		else {
+			region.First = Vertices.size();
+			region.Capacity = MinRegionSize;
+			while (region.Capacity < count)
+				region.Capacity *= 2;
+			Vertices.resize(region.First + region.Capacity);
+		}
+	}
+
+	QuadCount -= region.Quads;
+	region.Quads = count / 4;
+	QuadCount += region.Quads;
+	if (count == 0)
+		return;
+	glm::vec3 min = Scratch[0].Position;
+	glm::vec3 max = min;
+	for (const Vertex& vertex : Scratch) {
+		min = glm::min(min, vertex.Position);
+		max = glm::max(max, vertex.Position);
+	}
+	Bounds.Set(chunk, min, max);
+	std::copy(Scratch.begin(), Scratch.end(), Vertices.begin() + region.First);
+	if (!IsDirty()) {
+		DirtyBegin = region.First;
+		DirtyEnd = region.First + count;
+	}
+	else {
+		DirtyBegin = std::min(DirtyBegin, region.First);
+		DirtyEnd = std::max(DirtyEnd, region.First + count);
+	}
+}
+
+void StackMesher::MarkClean() {
+	DirtyBegin = DirtyEnd = 0;
+}
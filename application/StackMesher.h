@@ -0,0 +1,114 @@
+#ifndef STACKMESHER_H_
+#define STACKMESHER_H_
+
+#include "GameState.h"
+#include "FrustumPlanes.h"
+#include "glm/glm.hpp"
+
+#include <cstddef>
+#include <vector>
+
+// =============================================================================
+// StackMesher
+// =============================================================================
+// Mesh of the landed cubes where the faces between two cubes, or between a
+// cube and a wall, are left out and the faces that are left are merged into
+// as few quads as they can be. The layers are split in chunks of 16x16 cells,
+// every chunk has its own region of one vertex array and its own bounding
+// box, ready to be uploaded to a vertex buffer and drawn with one indirect
+// command per chunk. Only the layers that were touched since the last update
+// are meshed again, the vertices that changed are kept as a dirty range.
+class StackMesher
+{
+public:
+	// One corner of a quad. The positions are in cells: cell (x,y,z) goes from
+	// x,y,z to x+1,y+1,z+1, so the edges of the cubes are whole numbers.
+	struct Vertex
+	{
+		glm::vec3 Position;
+		glm::vec3 Normal;
+		glm::vec2 Edge;		// the position along the two sides of the face
+		glm::vec4 Color;
+	};
+
+	// The color of the cubes in a layer
+	using ColorFunction = glm::vec4(*)(int layer);
+
+	// Cells across a chunk
+	static constexpr int ChunkSize = 16;
+
+public:
+	// width, height, depth - size of the pit in cells
+	// color - the color of the cubes of each layer
+	StackMesher(int width, int height, int depth, ColorFunction color);
+
+	// Marks the layers from first to last as changed. The faces between two
+	// layers depend on both, so the layers next to them are meshed again too.
+	void Invalidate(int first, int last);
+	// Meshes the changed layers again from the pit.
+	// Returns true if any chunk was meshed.
+	bool Update(const Pit& pit);
+
+	// Vertices of every chunk, the regions of the chunks can have unused
+	// space after them
+	const std::vector<Vertex>& GetVertices() const { return Vertices; }
+	size_t GetVertexCount() const { return Vertices.size(); }
+	// The chunks go layer by layer from the back wall, row by row in a layer
+	size_t GetChunkCount() const { return Chunks.size(); }
+	// The first vertex and the number of quads of a chunk
+	size_t GetChunkFirst(size_t chunk) const { return Chunks[chunk].First; }
+	size_t GetChunkQuads(size_t chunk) const { return Chunks[chunk].Quads; }
+	// Box around the quads of every chunk, in cells
+	const BoundingBoxes& GetChunkBounds() const { return Bounds; }
+	// The most quads any chunk has, four vertices each
+	size_t GetMaxChunkQuads() const { return MaxChunkQuads; }
+	// Quads in the mesh and the cubes they cover
+	size_t GetQuadCount() const { return QuadCount; }
+	size_t GetCubeCount() const { return CubeCount; }
+
+	// The vertices changed since the last MarkClean
+	bool IsDirty() const { return DirtyBegin < DirtyEnd; }
+	size_t GetDirtyBegin() const { return DirtyBegin; }
+	size_t GetDirtyEnd() const { return DirtyEnd; }
+	void MarkClean();
+
+private:
+	struct Region
+	{
+		size_t First = 0;
+		size_t Capacity = 0;	// vertices
+		size_t Quads = 0;
+		size_t Cubes = 0;
+	};
+
+	// Meshes one chunk into Scratch
+	void MeshChunk(const Pit& pit, size_t chunk);
+	// Merges the faces in the mask, which is sizeU by sizeV cells, into quads
+	// and adds them to Scratch. axis and side tell which way the faces look,
+	// origin is the cell of mask entry (0,0).
+	void MergeFaces(std::vector<char>& mask, int sizeU, int sizeV, int axis, int side,
+		const glm::ivec3& origin, const glm::vec4& color);
+	// Moves Scratch into the region of a chunk, the region moves if it is too small
+	void Place(size_t chunk);
+
+private:
+	ColorFunction Color;
+	int Width;
+	int Height;
+	int ChunksX;
+	int ChunksY;
+	std::vector<Region> Chunks;
+	BoundingBoxes Bounds;
+	std::vector<Region> FreeRegions;
+	std::vector<Vertex> Vertices;
+	std::vector<Vertex> Scratch;
+	std::vector<char> Mask;
+	std::vector<bool> Changed;
+	size_t MaxChunkQuads = 0;
+	size_t QuadCount = 0;
+	size_t CubeCount = 0;
+	size_t DirtyBegin = 0;
+	size_t DirtyEnd = 0;
+};
+
+#endif // STACKMESHER_H_
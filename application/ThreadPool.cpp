@@ -0,0 +1,109 @@
+#include "ThreadPool.h"
+
+namespace {
+	// The pool and queue of the worker running on this thread
+	thread_local const ThreadPool* currentPool = nullptr;
+	thread_local unsigned int currentIndex = 0;
+}
+
+ThreadPool::ThreadPool(unsigned int threads) {
+	if (threads == 0)
+		threads = std::thread::hardware_concurrency();
+	if (threads == 0)
+		threads = 1;
+	for (unsigned int i = 0; i < threads; i++)
+		Queues.push_back(std::make_unique<Queue>());
+	for (unsigned int i = 0; i < threads; i++)
+		Workers.emplace_back(&ThreadPool::WorkerLoop, this, i);
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		std::lock_guard<std::mutex> lock(WakeMutex);
+		Stopping = true;
+	}
+	WakeUp.notify_all();
+	for (auto& worker : Workers)
+		worker.join();
+}
+
+void ThreadPool::Submit(Task task) {
+	unsigned int index = currentPool == this ? currentIndex
+		: NextQueue.fetch_add(1, std::memory_order_relaxed) % Queues.size();
+	Pending++;
+	{
+		std::lock_guard<std::mutex> lock(Queues[index]->Mutex);
+		Queues[index]->Tasks.push_back(std::move(task));
+	}
+	Queued++;
+	//taking the lock keeps a worker from missing the wake up between
+	// checking the queues and going to sleep
+	{
+		std::lock_guard<std::mutex> lock(WakeMutex);
+	}
+	WakeUp.notify_one();
+}
+
+bool ThreadPool::TryPop(unsigned int index, Task& task) {
+	Queue& queue = *Queues[index];
+	std::lock_guard<std::mutex> lock(queue.Mutex);
+	if (queue.Tasks.empty())
+		return false;
+	task = std::move(queue.Tasks.back());
+	queue.Tasks.pop_back();
+	Queued--;
+	return true;
+}
+
+bool ThreadPool::TrySteal(unsigned int thief, Task& task) {
+	const size_t count = Queues.size();
+	for (size_t i = 1; i <= count; i++) {
+		Queue& queue = *Queues[(thief + i) % count];
+		std::lock_guard<std::mutex> lock(queue.Mutex);
+		if (queue.Tasks.empty())
+			continue;
+		task = std::move(queue.Tasks.front());
+		queue.Tasks.pop_front();
+		Queued--;
+		return true;
+	}
+	return false;
+}
+
+void ThreadPool::Execute(Task& task) {
+	task();
+	task = nullptr;
+	if (--Pending == 0) {
+		std::lock_guard<std::mutex> lock(WakeMutex);
+		Done.notify_all();
+	}
+}
+
+void ThreadPool::Wait() {
+	Task task;
+	while (Pending > 0) {
+		if (TrySteal(0, task)) {
+			Execute(task);
+			continue;
+		}
+		//the rest is running on the workers
+		std::unique_lock<std::mutex> lock(WakeMutex);
+		Done.wait(lock, [this]() { return Pending == 0 || Queued > 0; });
+	}
+}
+
+void ThreadPool::WorkerLoop(unsigned int index) {
+	currentPool = this;
+	currentIndex = index;
+	Task task;
+	while (true) {
+		if (TryPop(index, task) || TrySteal(index, task)) {
+			Execute(task);
+			continue;
+		}
+		std::unique_lock<std::mutex> lock(WakeMutex);
+		WakeUp.wait(lock, [this]() { return Stopping || Queued > 0; });
+		if (Stopping && Queued == 0)
+			return;
+	}
+}
@@ -0,0 +1,65 @@
+#ifndef THREADPOOL_H_
+#define THREADPOOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// =============================================================================
+// ThreadPool
+// =============================================================================
+// Fixed set of worker threads with one task queue each. A worker takes the
+// newest task from its own queue and steals the oldest one from the others
+// when it runs dry, so a batch of uneven tasks still keeps every core busy.
+// The thread that waits for a batch helps running it.
+class ThreadPool
+{
+public:
+	using Task = std::function<void()>;
+
+	// threads - number of workers, 0 for one per core
+	explicit ThreadPool(unsigned int threads = 0);
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	// Queue a task. Tasks queued from a worker go to its own queue.
+	void Submit(Task task);
+	// Run tasks until everything that was submitted is done
+	void Wait();
+
+	inline unsigned int GetThreadCount() const { return static_cast<unsigned int>(Workers.size()); }
+
+private:
+	struct Queue
+	{
+		std::mutex Mutex;
+		std::deque<Task> Tasks;
+	};
+
+	// Newest task of a queue
+	bool TryPop(unsigned int index, Task& task);
+	// Oldest task of any queue, starting after the one of the thief
+	bool TrySteal(unsigned int thief, Task& task);
+	void Execute(Task& task);
+	void WorkerLoop(unsigned int index);
+
+private:
+	std::vector<std::unique_ptr<Queue>> Queues;
+	std::vector<std::thread> Workers;
+	std::atomic<int> Queued{ 0 };	// tasks waiting in the queues
+	std::atomic<int> Pending{ 0 };	// tasks submitted and not done yet
+	std::atomic<unsigned int> NextQueue{ 0 };
+	std::atomic<bool> Stopping{ false };
+	std::mutex WakeMutex;
+	std::condition_variable WakeUp;	// tasks were queued or the pool stops
+	std::condition_variable Done;	// the last pending task finished
+};
+
+#endif // THREADPOOL_H_
@@ -0,0 +1,157 @@
+#include "GameState.h"
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+/**
+* Compares the collision queries done with the occupancy grid against the old
+* linear scans over the translation vectors of every solid cube. The pit is
+* filled up to the layer under the starting position except for one cell, which
+* is the worst case for the scans since they always walk the whole list. The
+* last run answers bottom() with the height map of the pit instead.
+*
+* @file CollisionBenchmark.cpp
+*/
+
+namespace {
+
+	constexpr int Width = 5;
+	constexpr int Height = 5;
+	constexpr int Depth = 10;
+	constexpr int Rounds = 2000;
+	const PitSpace Space(Width, Height, Depth);
+
+	bool floatEqual(float a, float b) {
+		return a <= b + 0.0001f && a >= b - 0.0001f;
+	}
+
+	// The scans as they were done in BlockOutApp.cpp before the grid, with the
+	// wall checks that keyInput did in front of them
+	bool scanCollision(const glm::vec3& cubePos,
+		const std::vector<glm::vec3>& cubeTranslationVectors, const glm::vec3& dir) {
+		glm::vec3 target = cubePos + dir;
+		if (target.x > 0.41f || target.x < -0.41f || target.y > 0.41f ||
+			target.y < -0.41f || target.z < 0.0f)
+			return true;
+		for (size_t i = 1; i < cubeTranslationVectors.size(); i++) {
+			if (floatEqual(cubeTranslationVectors[i].z, cubePos.z + dir.z) &&
+				floatEqual(cubeTranslationVectors[i].y, cubePos.y + dir.y) &&
+				floatEqual(cubeTranslationVectors[i].x, cubePos.x + dir.x))
+				return true;
+		}
+		return false;
+	}
+
+	float scanBottom(const glm::vec3& cubePos,
+		const std::vector<glm::vec3>& cubeTranslationVectors) {
+		float bot = 0.1f;
+		for (size_t i = 1; i < cubeTranslationVectors.size(); i++) {
+			if (floatEqual(cubePos.x, cubeTranslationVectors[i].x) &&
+				floatEqual(cubePos.y, cubeTranslationVectors[i].y))
+				bot = cubeTranslationVectors[i].z + 0.2f;
+		}
+		return bot;
+	}
+
+	// The same queries answered by the grid
+	bool gridCollision(const glm::vec3& cubePos, const OccupancyGrid& pit,
+		const glm::ivec3& dir) {
+		glm::ivec3 cell = Space.CellFromWorld(cubePos);
+		return pit.IsSolid(cell.x + dir.x, cell.y + dir.y, cell.z + dir.z);
+	}
+
+	float gridBottom(const glm::vec3& cubePos, const OccupancyGrid& pit) {
+		glm::ivec3 cell = Space.CellFromWorld(cubePos);
+		int z;
+		for (z = pit.GetDepth() - 1; z >= 0; z--) {
+			if (pit.IsSolid(cell.x, cell.y, z))
+				break;
+		}
+		return Space.WorldFromCell(glm::ivec3(cell.x, cell.y, z + 1)).z;
+	}
+
+	float heightMapBottom(const glm::vec3& cubePos, const Pit& pit) {
+		glm::ivec3 cell = Space.CellFromWorld(cubePos);
+		int top = pit.GetColumnTop(cell.x, cell.y);
+		return Space.WorldFromCell(glm::ivec3(cell.x, cell.y, top)).z;
+	}
+
+	template<typename F>
+	double nanosecondsPerQuery(long long queries, F&& body) {
+		auto start = std::chrono::steady_clock::now();
+		body();
+		auto end = std::chrono::steady_clock::now();
+		return std::chrono::duration<double, std::nano>(end - start).count() / queries;
+	}
+}
+
+int main()
+{
+	// nearly full pit, the first vector is the starting position like in the game
+	Pit pit(Width, Height, Depth);
+	std::vector<glm::vec3> cubeTranslationVectors;
+	cubeTranslationVectors.push_back(Space.WorldFromCell(glm::ivec3(0, 0, Depth - 1)));
+	for (int z = 0; z < Depth - 1; z++)
+		for (int y = 0; y < Height; y++)
+			for (int x = 0; x < Width; x++) {
+				if (x == Width - 1 && y == Height - 1 && z == Depth - 2)
+					continue;
+				glm::ivec3 cell(x, y, z);
+				pit.AddCube(cell);
+				cubeTranslationVectors.push_back(Space.WorldFromCell(cell));
+			}
+
+	// every cell of the spawn layer with the four queries that the game does
+	std::vector<glm::vec3> positions;
+	for (int y = 0; y < Height; y++)
+		for (int x = 0; x < Width; x++)
+			positions.push_back(Space.WorldFromCell(glm::ivec3(x, y, Depth - 1)));
+	const long long queries = static_cast<long long>(Rounds) * positions.size() * 4;
+
+	long long checksum = 0;
+	double scan = nanosecondsPerQuery(queries, [&]() {
+		for (int r = 0; r < Rounds; r++)
+			for (const auto& pos : positions) {
+				checksum += scanCollision(pos, cubeTranslationVectors, glm::vec3(0.2f, 0.0f, 0.0f));
+				checksum += scanCollision(pos, cubeTranslationVectors, glm::vec3(0.0f, 0.2f, 0.0f));
+				checksum += scanCollision(pos, cubeTranslationVectors, glm::vec3(0.0f, 0.0f, -0.2f));
+				checksum += std::lround(scanBottom(pos, cubeTranslationVectors) * 10.0f);
+			}
+		});
+
+	long long gridChecksum = 0;
+	double grid = nanosecondsPerQuery(queries, [&]() {
+		for (int r = 0; r < Rounds; r++)
+			for (const auto& pos : positions) {
+				gridChecksum += gridCollision(pos, pit.GetCells(), glm::ivec3(1, 0, 0));
+				gridChecksum += gridCollision(pos, pit.GetCells(), glm::ivec3(0, 1, 0));
+				gridChecksum += gridCollision(pos, pit.GetCells(), glm::ivec3(0, 0, -1));
+				gridChecksum += std::lround(gridBottom(pos, pit.GetCells()) * 10.0f);
+			}
+		});
+
+	long long heightMapChecksum = 0;
+	double heightMap = nanosecondsPerQuery(queries, [&]() {
+		for (int r = 0; r < Rounds; r++)
+			for (const auto& pos : positions) {
+				heightMapChecksum += gridCollision(pos, pit.GetCells(), glm::ivec3(1, 0, 0));
+				heightMapChecksum += gridCollision(pos, pit.GetCells(), glm::ivec3(0, 1, 0));
+				heightMapChecksum += gridCollision(pos, pit.GetCells(), glm::ivec3(0, 0, -1));
+				heightMapChecksum += std::lround(heightMapBottom(pos, pit) * 10.0f);
+			}
+		});
+
+	std::cout << "Solid cubes: " << cubeTranslationVectors.size() - 1 << "\n";
+	std::cout << "Queries: " << queries << "\n";
+	std::cout << "Linear scan:     " << scan << " ns/query\n";
+	std::cout << "Occupancy grid:  " << grid << " ns/query\n";
+	std::cout << "Grid + height map: " << heightMap << " ns/query\n";
+	std::cout << "Speedup: " << scan / grid << "x (grid), "
+		<< scan / heightMap << "x (grid + height map)\n";
+	// the checksums keep the compiler from removing the loops
+	if (checksum != gridChecksum || checksum != heightMapChecksum)
+		std::cout << "Warning: the grid and the scans disagree\n";
+	return 0;
+}
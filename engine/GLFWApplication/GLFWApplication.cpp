@@ -60,12 +60,48 @@ unsigned int GLFWApplication::ParseArguments(int argc, char** argv){
 
 		TCLAP::ValueArg<int> widthArg("w", "width", "width", false, 800, "int");
 		TCLAP::ValueArg<int> heightArg("g", "height", "height", false, 800, "int");
+		TCLAP::SwitchArg headlessArg("", "headless", "run without a window", false);
+		TCLAP::ValueArg<std::string> replayArg("", "replay", "input stream to play back", false, "", "file");
+		TCLAP::ValueArg<std::string> recordArg("", "record", "save the input stream to a file", false, "", "file");
+		TCLAP::ValueArg<unsigned long long> ticksArg("", "ticks", "ticks to run headless", false, 0, "int");
+		TCLAP::ValueArg<std::string> piecesArg("", "pieces", "piece set: cube, flat, basic or extended", false, "basic", "set");
+		TCLAP::SwitchArg autoplayArg("", "autoplay", "let the autoplayer play", false);
+		TCLAP::ValueArg<unsigned int> threadsArg("", "threads", "autoplayer threads, 0 for one per core", false, 0, "int");
+		TCLAP::ValueArg<int> pitWidthArg("", "pit-width", "cells across the pit", false, 5, "int");
+		TCLAP::ValueArg<int> pitHeightArg("", "pit-height", "cells up the pit", false, 5, "int");
+		TCLAP::ValueArg<int> pitDepthArg("", "pit-depth", "cells from the opening to the back wall", false, 10, "int");
+		TCLAP::SwitchArg statsArg("", "stats", "print the startup time and render statistics", false);
+		TCLAP::ValueArg<std::string> shaderCacheArg("", "shader-cache", "directory of the linked shader programs, empty for none", false, "shader_cache", "dir");
 		cmd.add(widthArg);
 		cmd.add(heightArg);
+		cmd.add(headlessArg);
+		cmd.add(replayArg);
+		cmd.add(recordArg);
+		cmd.add(ticksArg);
+		cmd.add(piecesArg);
+		cmd.add(autoplayArg);
+		cmd.add(threadsArg);
+		cmd.add(pitWidthArg);
+		cmd.add(pitHeightArg);
+		cmd.add(pitDepthArg);
+		cmd.add(shaderCacheArg);
+		cmd.add(statsArg);
 
 		cmd.parse(argc, argv);
 		height = heightArg.getValue();
 		width = widthArg.getValue();
+		headless = headlessArg.getValue();
+		replayFile = replayArg.getValue();
+		recordFile = recordArg.getValue();
+		ticks = ticksArg.getValue();
+		pieceSet = piecesArg.getValue();
+		autoplay = autoplayArg.getValue();
+		threads = threadsArg.getValue();
+		pitWidth = pitWidthArg.getValue();
+		pitHeight = pitHeightArg.getValue();
+		pitDepth = pitDepthArg.getValue();
+		shaderCache = shaderCacheArg.getValue();
+		stats = statsArg.getValue();
 
 	}
 	catch (TCLAP::ArgException& e)
@@ -81,6 +117,14 @@ void GLFWErrorCallback(int code, const char* description)
 	std::cerr << "Error " << "0x" << std::hex << code << ':' << description << "\n";
 }
 
+//Key callback, GLFW calls it from glfwPollEvents
+void GLFWApplication::KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods)
+{
+	auto* application = static_cast<GLFWApplication*>(glfwGetWindowUserPointer(window));
+	if (!application->keyEvents.Push({ key, action, mods, glfwGetTime() }))
+		application->droppedKeyEvents++;
+}
+
 // Initialization 
 unsigned int GLFWApplication::Init(){ // Virtual function with defaut behavior
 	glfwSetErrorCallback(GLFWErrorCallback);
@@ -108,6 +152,8 @@ unsigned int GLFWApplication::Init(){ // Virtual function with defaut behavior
 	}
 
 	glfwMakeContextCurrent(window);
+	glfwSetWindowUserPointer(window, this);
+	glfwSetKeyCallback(window, KeyCallback);
 	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
 	{
 		std::cout << "Failed to initialize GLAD" << std::endl;
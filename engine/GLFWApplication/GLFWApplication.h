@@ -4,15 +4,44 @@
 #include <tclap/CmdLine.h>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
+#include "SPSCQueue.h"
+
+// A key going down, up or repeating, as GLFW reported it
+struct KeyEvent
+{
+	int key;
+	int action;		// GLFW_PRESS, GLFW_RELEASE or GLFW_REPEAT
+	int mods;
+	double time;	// glfwGetTime when the key was reported
+};
+
 class GLFWApplication
 {
 private:
+	// Puts the key events of the window in the queue
+	static void KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods);
 
 
 protected:
 	GLFWwindow* window;
 	int width = 0;
 	int height = 0;
+	bool headless = false;		// run without a window or GL context
+	std::string replayFile;		// input stream to play back
+	std::string recordFile;		// where to save the input stream
+	unsigned long long ticks = 0;	// number of ticks to run headless, 0 for the replay length
+	std::string pieceSet = "basic";	// pieces handed out: cube, flat, basic or extended
+	bool autoplay = false;		// let the autoplayer play the game
+	unsigned int threads = 0;	// threads of the autoplayer, 0 for one per core
+	int pitWidth = 5;			// cells across the pit
+	int pitHeight = 5;			// cells up the pit
+	int pitDepth = 10;			// cells from the opening to the back wall
+	std::string shaderCache = "shader_cache";	// where linked shader programs are kept, empty for none
+	bool stats = false;			// print the startup time and render statistics
+	// keys in the order they came in, filled by glfwPollEvents and emptied by
+	// Run, which is const
+	mutable SPSCQueue<KeyEvent, 256> keyEvents;
+	unsigned long long droppedKeyEvents = 0;	// keys lost to a full queue
 public:
 	GLFWApplication() = default;
 	GLFWApplication(const std::string& name, const std::string& version);
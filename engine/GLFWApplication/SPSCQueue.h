@@ -0,0 +1,52 @@
+#ifndef SPSCQUEUE_H_
+#define SPSCQUEUE_H_
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+// =============================================================================
+// SPSCQueue
+// =============================================================================
+// Lock-free ring buffer for one thread that pushes and one thread that pops.
+// The two sides only share the head and the tail index, each written by one
+// side, so neither of them ever waits for the other.
+template<typename T, std::size_t Capacity>
+class SPSCQueue
+{
+	static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0,
+		"the capacity must be a power of two");
+
+public:
+	// Adds an item at the back. Returns false if the queue is full.
+	bool Push(const T& item) {
+		const std::size_t tail = Tail.load(std::memory_order_relaxed);
+		if (tail - Head.load(std::memory_order_acquire) == Capacity)
+			return false;
+		Items[tail & (Capacity - 1)] = item;
+		Tail.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Takes the item at the front. Returns false if the queue is empty.
+	bool Pop(T& item) {
+		const std::size_t head = Head.load(std::memory_order_relaxed);
+		if (head == Tail.load(std::memory_order_acquire))
+			return false;
+		item = Items[head & (Capacity - 1)];
+		Head.store(head + 1, std::memory_order_release);
+		return true;
+	}
+
+	bool Empty() const {
+		return Head.load(std::memory_order_acquire) == Tail.load(std::memory_order_acquire);
+	}
+
+private:
+	std::array<T, Capacity> Items{};
+	// on their own cache lines so the two sides do not slow each other down
+	alignas(64) std::atomic<std::size_t> Head{ 0 };
+	alignas(64) std::atomic<std::size_t> Tail{ 0 };
+};
+
+#endif // SPSCQUEUE_H_
@@ -67,13 +67,28 @@ namespace GeometricTools {
 		1,7,13,		1,13,19		//Bottom
 
 	};
+	// Floats per vertex of Cube3DWNormals: position(3), normal(3) and the
+	// coordinates of the vertex across its face(2)
+	constexpr int CubeVertexSize = 3 + 3 + 2;
+
+	// The cube with normals scaled down by X. Every vertex also gets where it
+	// is on its face, 0 or 1 along the two sides of the face, so a fragment
+	// knows how far it is from the edges of the face it is on
 	template<typename T>
 	std::vector<float> Cube3DWNormals(T X) {
 		std::vector<float>cube;
-		cube.resize(3 * 24 * 2);
-		for (int i = 0; i < cube.size(); i++)
+		cube.reserve(CubeVertexSize * 24);
+		for (int i = 0; i < 24; i++)
 		{
-			cube[i] = UnitCube3D24WNormals[i] / X;
+			const float* vertex = &UnitCube3D24WNormals[i * 6];
+			for (int k = 0; k < 6; k++)
+				cube.push_back(vertex[k] / X);
+			//the two axes along the face are the ones the normal is 0 on
+			for (int k = 0; k < 3; k++)
+			{
+				if (vertex[3 + k] == 0.0f)
+					cube.push_back(vertex[k] + 0.5f);
+			}
 		}
 		return cube;
 	};
@@ -183,6 +198,106 @@ namespace GeometricTools {
 		return vbo;
 	}
 
+	// ============================================
+	// Pit
+	// ============================================
+
+	// Floats per vertex of the pit: position(3), normal(3), texture
+	// coordinates(2) and checker parity(1)
+	constexpr int PitVertexSize = 3 + 3 + 2 + 1;
+
+	// The four walls and the back wall of a pit of width x height x depth
+	// cells in one mesh, one quad per cell. The pit is centered on x and y
+	// with the back wall at z = 0 and the open end at z = depth * cellSize.
+	// The normals point into the pit and the parity is 0 or 1 for the two
+	// colors of the checkerboard, the walls that meet along the sides of the
+	// pit start on different colors.
+	template<typename T>
+	std::vector<float> PitGeometryWNormals(T width, T height, T depth, float cellSize)
+	{
+		std::vector<float> vbo;
+		vbo.reserve((2 * (width + height) * depth + width * height) * 4 * PitVertexSize);
+		const float halfWidth = 0.5f * width * cellSize;
+		const float halfHeight = 0.5f * height * cellSize;
+
+		//adds one wall made of a x b cells. corner is where cell 0,0 starts,
+		// along a and along b are the sides of one cell and first is the
+		// parity of cell 0,0
+		auto addWall = [&](T a, T b, const std::array<float, 3>& corner,
+			const std::array<float, 3>& alongA, const std::array<float, 3>& alongB,
+			const std::array<float, 3>& normal, int first)
+		{
+			for (T j = 0; j < b; ++j)
+			{
+				for (T i = 0; i < a; ++i)
+				{
+					const float parity = static_cast<float>((first + i + j) & 1);
+					for (int v = 0; v < 4; ++v)
+					{
+						const T u = i + (v & 1);
+						const T w = j + (v >> 1);
+						for (int k = 0; k < 3; ++k)
+							vbo.push_back(corner[k] + u * alongA[k] + w * alongB[k]);
+						vbo.insert(vbo.end(), normal.begin(), normal.end());
+						vbo.push_back(u / static_cast<float>(a));
+						vbo.push_back(w / static_cast<float>(b));
+						vbo.push_back(parity);
+					}
+				}
+			}
+		};
+
+		//the parity of a cell is the one of the cell just behind it in the pit
+		// grid, with the top and bottom flipped so they never match the
+		// sides along the edges
+		const float c = cellSize;
+		const int w = static_cast<int>(width);
+		const int h = static_cast<int>(height);
+		//left and right, y by z
+		addWall(height, depth, { -halfWidth, -halfHeight, 0.0f }, { 0.0f, c, 0.0f }, { 0.0f, 0.0f, c },
+			{ 1.0f, 0.0f, 0.0f }, 1);
+		addWall(height, depth, { halfWidth, -halfHeight, 0.0f }, { 0.0f, c, 0.0f }, { 0.0f, 0.0f, c },
+			{ -1.0f, 0.0f, 0.0f }, w & 1);
+		//bottom and top, x by z
+		addWall(width, depth, { -halfWidth, -halfHeight, 0.0f }, { c, 0.0f, 0.0f }, { 0.0f, 0.0f, c },
+			{ 0.0f, 1.0f, 0.0f }, 0);
+		addWall(width, depth, { -halfWidth, halfHeight, 0.0f }, { c, 0.0f, 0.0f }, { 0.0f, 0.0f, c },
+			{ 0.0f, -1.0f, 0.0f }, (h + 1) & 1);
+		//back, x by y
+		addWall(width, height, { -halfWidth, -halfHeight, 0.0f }, { c, 0.0f, 0.0f }, { 0.0f, c, 0.0f },
+			{ 0.0f, 0.0f, 1.0f }, 1);
+		return vbo;
+	}
+
+	// Two triangles for every quad of PitGeometryWNormals
+	template<typename T>
+	std::vector<GLuint> PitTopology(T width, T height, T depth)
+	{
+		const GLuint quads = 2 * (width + height) * depth + width * height;
+		std::vector<GLuint> topology;
+		topology.reserve(6 * quads);
+		for (GLuint q = 0; q < quads; ++q)
+		{
+			const GLuint k = 4 * q;
+			topology.insert(topology.end(), { k, k + 1, k + 2, k + 1, k + 3, k + 2 });
+		}
+		return topology;
+	}
+
+	// Two triangles for every quad of four vertices that go around the quad
+	template<typename T>
+	std::vector<GLuint> QuadTopology(T quads)
+	{
+		std::vector<GLuint> topology;
+		topology.reserve(6 * quads);
+		for (GLuint q = 0; q < static_cast<GLuint>(quads); ++q)
+		{
+			const GLuint k = 4 * q;
+			topology.insert(topology.end(), { k, k + 1, k + 2, k + 2, k + 3, k });
+		}
+		return topology;
+	}
+
 }
 
 
@@ -3,6 +3,7 @@
 
 #include "glm/fwd.hpp"
 #include "glm/ext.hpp"
+#include "FrustumPlanes.h"
 
 class Camera
 {
@@ -23,6 +24,11 @@ public:
     {
         return this->ViewProjectionMatrix;
     }
+    // The planes around what the camera sees, made again with the matrices
+    const FrustumPlanes& GetFrustumPlanes() const
+    {
+        return this->Frustum;
+    }
 
     // Set/Get position
     const glm::vec3& GetPosition() const
@@ -44,6 +50,7 @@ protected:
         this->ViewMatrix = camera.ViewMatrix;
         this->Position = camera.Position;
         this->ViewProjectionMatrix = camera.ViewProjectionMatrix;
+        this->Frustum = camera.Frustum;
     }
 
 protected:
@@ -51,6 +58,7 @@ protected:
     glm::mat4 ViewMatrix = glm::mat4(1.0f);
     glm::mat4 ViewProjectionMatrix = glm::mat4(1.0f);
     glm::vec3 Position = glm::vec3(0.0f);
+    FrustumPlanes Frustum;
 };
 
 #endif // CAMERA_H_
@@ -0,0 +1,149 @@
+#include "ComputeCuller.h"
+
+#include <algorithm>
+#include "cstring"
+#include "string"
+
+namespace {
+	constexpr GLuint GroupSize = 64;
+
+	// One invocation per item, the binding points are filled in by
+	// the constructor
+	std::string CullShaderSource(GLuint firstBinding) {
+		auto binding = [firstBinding](ComputeCuller::Binding offset) {
+			return std::to_string(firstBinding + offset);
+		};
+		return R"(
+		#version 460 core
+		layout(local_size_x = )" + std::to_string(GroupSize) + R"() in;
+
+		struct Command
+		{
+			uint count;
+			uint instanceCount;
+			uint firstIndex;
+			int baseVertex;
+			uint baseInstance;
+		};
+		struct Item
+		{
+			vec4 boxMin;
+			vec4 boxMax;
+			Command command;
+			uint enabled;
+		};
+		layout(std430, binding = )" + binding(ComputeCuller::Items) + R"() readonly buffer Items
+		{
+			Item items[];
+		};
+		layout(std430, binding = )" + binding(ComputeCuller::Commands) + R"() writeonly buffer Commands
+		{
+			Command commands[];
+		};
+		layout(std430, binding = )" + binding(ComputeCuller::Survivors) + R"() writeonly buffer Survivors
+		{
+			uint survivors[];
+		};
+		layout(std430, binding = )" + binding(ComputeCuller::DrawCount) + R"() buffer DrawCount
+		{
+			uint drawCount;
+		};
+
+		uniform vec4 u_planes[6];
+		uniform int u_itemCount;
+
+		void main(){
+			uint i = gl_GlobalInvocationID.x;
+			if(i >= uint(u_itemCount))
+				return;
+			Item item = items[i];
+			if(item.enabled == 0 || item.command.count == 0 || item.command.instanceCount == 0)
+				return;
+			for(int p = 0; p < 6; p++){
+				//the corner furthest along the normal of the plane
+				vec3 corner = mix(item.boxMin.xyz, item.boxMax.xyz, greaterThanEqual(u_planes[p].xyz, vec3(0.0)));
+				if(dot(u_planes[p].xyz, corner) + u_planes[p].w < 0.0)
+					return;
+			}
+			uint slot = atomicAdd(drawCount, 1u);
+			commands[slot] = item.command;
+			survivors[slot] = i;
+		}
+		)";
+	}
+}
+
+ComputeCuller::ComputeCuller(size_t count, GLuint firstBinding)
+	: FirstBinding(firstBinding),
+	ItemData(count, Item{ glm::vec4(0.0f), glm::vec4(0.0f), { 0, 0, 0, 0, 0 }, 1, { 0, 0 } }),
+	DirtyBegin(0), DirtyEnd(count),
+	ItemBuffer(nullptr, count * sizeof(Item), firstBinding + Items),
+	SurvivorBuffer(nullptr, count * sizeof(GLuint), firstBinding + Survivors),
+	DrawCountBuffer(nullptr, sizeof(GLuint), firstBinding + DrawCount) {
+	static_assert(sizeof(Item) == 64, "Item must match the std430 layout");
+	//room for a command of every item, the compute shader writes them
+	CommandBuffer = std::make_shared<IndirectBuffer>();
+	for (size_t i = 0; i < count; i++)
+		CommandBuffer->Add(ItemData[i].Command);
+	CommandBuffer->Upload();
+
+	CullShader = std::make_shared<Shader>(CullShaderSource(firstBinding));
+	PlanesLocation = CullShader->GetUniformLocation("u_planes");
+	ItemCount = CullShader->Uniform<int>("u_itemCount");
+}
+
+void ComputeCuller::Set(size_t index, const glm::vec3& min, const glm::vec3& max,
+	const DrawElementsIndirectCommand& command) {
+	Item item = ItemData[index];
+	item.Min = glm::vec4(min, 1.0f);
+	item.Max = glm::vec4(max, 1.0f);
+	item.Command = command;
+	if (std::memcmp(&item, &ItemData[index], sizeof(Item)) == 0)
+		return;
+	ItemData[index] = item;
+	MarkDirty(index);
+}
+
+void ComputeCuller::SetEnabled(size_t index, bool enabled) {
+	if (ItemData[index].Enabled == static_cast<GLuint>(enabled))
+		return;
+	ItemData[index].Enabled = enabled;
+	MarkDirty(index);
+}
+
+void ComputeCuller::MarkDirty(size_t index) {
+	if (DirtyBegin >= DirtyEnd) {
+		DirtyBegin = index;
+		DirtyEnd = index + 1;
+		return;
+	}
+	DirtyBegin = std::min(DirtyBegin, index);
+	DirtyEnd = std::max(DirtyEnd, index + 1);
+}
+
+void ComputeCuller::Cull(const FrustumPlanes& planes) {
+	if (DirtyBegin < DirtyEnd) {
+		ItemBuffer.BufferSubData(DirtyBegin * sizeof(Item), (DirtyEnd - DirtyBegin) * sizeof(Item),
+			&ItemData[DirtyBegin]);
+		DirtyBegin = DirtyEnd = 0;
+	}
+	const GLuint zero = 0;
+	DrawCountBuffer.BufferSubData(0, sizeof(GLuint), &zero);
+
+	//other buffers may have been bound to the same points since the last call
+	ItemBuffer.Bind();
+	CommandBuffer->BindStorage(FirstBinding + Commands);
+	SurvivorBuffer.Bind();
+	DrawCountBuffer.Bind();
+
+	glm::vec4 planeData[FrustumPlanes::PlaneCount];
+	for (int p = 0; p < FrustumPlanes::PlaneCount; p++)
+		planeData[p] = planes.GetPlane(static_cast<FrustumPlanes::Plane>(p));
+	CullShader->Bind();
+	glUniform4fv(PlanesLocation, FrustumPlanes::PlaneCount, &planeData[0][0]);
+	ItemCount.Set(GetCount());
+	CullShader->Dispatch((static_cast<GLuint>(ItemData.size()) + GroupSize - 1) / GroupSize);
+	//the commands and the count are read by the draws, the survivors by
+	// their shaders
+	glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+}
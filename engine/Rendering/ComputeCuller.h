@@ -0,0 +1,85 @@
+#ifndef COMPUTECULLER_H_
+#define COMPUTECULLER_H_
+
+#include <glad/glad.h>
+#include "glm/glm.hpp"
+#include "FrustumPlanes.h"
+#include "IndirectBuffer.h"
+#include "Shader.h"
+#include "ShaderStorageBuffer.h"
+#include "memory"
+#include "vector"
+
+// =============================================================================
+// ComputeCuller
+// =============================================================================
+// Frustum culling on the GPU. Every item is a box with the command that draws
+// it. A compute shader tests the boxes against the planes and appends the
+// commands of the ones inside to an indirect buffer, next to each other, with
+// the index of each item in a second buffer so the draws know which item they
+// are. The number of commands stays on the GPU and is read by
+// RenderCommands::MultiDrawIndexIndirectCount, nothing is read back.
+class ComputeCuller
+{
+public:
+	// The shader storage binding points used, from the first one given
+	enum Binding { Items, Commands, Survivors, DrawCount, BindingCount };
+
+	// count - number of items
+	// firstBinding - the binding points from firstBinding to
+	//		firstBinding + BindingCount - 1 are taken by the culler
+	ComputeCuller(size_t count, GLuint firstBinding);
+
+	ComputeCuller(const ComputeCuller&) = delete;
+	ComputeCuller& operator=(const ComputeCuller&) = delete;
+
+	// The box of an item and the command that draws it, a command without
+	// indices or instances is never drawn. Only items that change are
+	// uploaded again.
+	void Set(size_t index, const glm::vec3& min, const glm::vec3& max,
+		const DrawElementsIndirectCommand& command);
+	// Items that are not enabled are never drawn, for culling done elsewhere
+	void SetEnabled(size_t index, bool enabled);
+
+	// Uploads the items that changed and culls them against the planes, in
+	// the space of the boxes. The draws made after it wait for the results.
+	void Cull(const FrustumPlanes& planes);
+
+	// The commands of the items that were inside, from the first one
+	inline const std::shared_ptr<IndirectBuffer>& GetCommands() const { return CommandBuffer; }
+	// Buffer with the number of commands at its start
+	inline GLuint GetDrawCountBuffer() const { return DrawCountBuffer.GetID(); }
+	// Most commands there can be, one for every item
+	inline GLsizei GetCount() const { return static_cast<GLsizei>(ItemData.size()); }
+	// Binding point of the uint array with the item of each command, it is
+	// left bound after Cull
+	inline GLuint GetSurvivorsBinding() const { return FirstBinding + Survivors; }
+
+private:
+	// As the std430 Item struct of the compute shader
+	struct Item
+	{
+		glm::vec4 Min;
+		glm::vec4 Max;
+		DrawElementsIndirectCommand Command;
+		GLuint Enabled;
+		GLuint Padding[2];
+	};
+
+	void MarkDirty(size_t index);
+
+private:
+	GLuint FirstBinding;
+	std::vector<Item> ItemData;
+	size_t DirtyBegin = 0;
+	size_t DirtyEnd = 0;
+	ShaderStorageBuffer ItemBuffer;
+	ShaderStorageBuffer SurvivorBuffer;
+	ShaderStorageBuffer DrawCountBuffer;
+	std::shared_ptr<IndirectBuffer> CommandBuffer;
+	std::shared_ptr<Shader> CullShader;
+	GLint PlanesLocation = -1;
+	UniformHandle<int> ItemCount;
+};
+
+#endif // COMPUTECULLER_H_
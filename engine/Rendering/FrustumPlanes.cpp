@@ -0,0 +1,131 @@
+#include "FrustumPlanes.h"
+
+#if defined(__AVX__)
+#define FRUSTUM_AVX
+#include <immintrin.h>
+#elif defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define FRUSTUM_SSE
+#include <xmmintrin.h>
+#endif
+
+size_t BoundingBoxes::Add(const glm::vec3& min, const glm::vec3& max) {
+	for (int axis = 0; axis < 3; axis++) {
+		Min[axis].push_back(min[axis]);
+		Max[axis].push_back(max[axis]);
+	}
+	return GetCount() - 1;
+}
+
+void BoundingBoxes::Set(size_t index, const glm::vec3& min, const glm::vec3& max) {
+	for (int axis = 0; axis < 3; axis++) {
+		Min[axis][index] = min[axis];
+		Max[axis][index] = max[axis];
+	}
+}
+
+void BoundingBoxes::Clear() {
+	for (int axis = 0; axis < 3; axis++) {
+		Min[axis].clear();
+		Max[axis].clear();
+	}
+}
+
+FrustumPlanes::FrustumPlanes(const glm::mat4& viewProjection) {
+	//a point is inside when -w <= x,y,z <= w in clip space, every side of
+	// that is a plane made of the rows of the matrix
+	const glm::mat4 rows = glm::transpose(viewProjection);
+	Planes[Left] = rows[3] + rows[0];
+	Planes[Right] = rows[3] - rows[0];
+	Planes[Bottom] = rows[3] + rows[1];
+	Planes[Top] = rows[3] - rows[1];
+	Planes[Near] = rows[3] + rows[2];
+	Planes[Far] = rows[3] - rows[2];
+	for (glm::vec4& plane : Planes) {
+		const float length = glm::length(glm::vec3(plane));
+		if (length > 0.0f)
+			plane /= length;
+	}
+}
+
+FrustumPlanes FrustumPlanes::Transformed(const glm::mat4& model) const {
+	//only the sign of the distance to a plane matters, so the planes are not
+	// made unit length again
+	FrustumPlanes transformed;
+	const glm::mat4 modelRows = glm::transpose(model);
+	for (int p = 0; p < PlaneCount; p++)
+		transformed.Planes[p] = modelRows * Planes[p];
+	return transformed;
+}
+
+bool FrustumPlanes::IsVisible(const glm::vec3& min, const glm::vec3& max) const {
+	for (const glm::vec4& plane : Planes) {
+		//the corner furthest along the normal of the plane
+		const glm::vec3 corner(plane.x >= 0.0f ? max.x : min.x,
+			plane.y >= 0.0f ? max.y : min.y, plane.z >= 0.0f ? max.z : min.z);
+		if (glm::dot(glm::vec3(plane), corner) + plane.w < 0.0f)
+			return false;
+	}
+	return true;
+}
+
+size_t FrustumPlanes::TestBoxes(const BoundingBoxes& boxes, std::vector<unsigned char>& visible) const {
+	const size_t count = boxes.GetCount();
+	visible.resize(count);
+	//the corner of every box that is furthest along the normal of each
+	// plane, picked once per plane instead of once per box
+	const float* corners[PlaneCount][3];
+	for (int p = 0; p < PlaneCount; p++) {
+		for (int axis = 0; axis < 3; axis++)
+			corners[p][axis] = Planes[p][axis] >= 0.0f ? boxes.GetMaxs(axis) : boxes.GetMins(axis);
+	}
+
+	size_t i = 0;
+	size_t inside = 0;
+#if defined(FRUSTUM_AVX)
+	for (; i + 8 <= count; i += 8) {
+		__m256 outside = _mm256_setzero_ps();
+		for (int p = 0; p < PlaneCount; p++) {
+			__m256 distance = _mm256_set1_ps(Planes[p].w);
+			for (int axis = 0; axis < 3; axis++) {
+				distance = _mm256_add_ps(distance, _mm256_mul_ps(_mm256_set1_ps(Planes[p][axis]),
+					_mm256_loadu_ps(corners[p][axis] + i)));
+			}
+			outside = _mm256_or_ps(outside, _mm256_cmp_ps(distance, _mm256_setzero_ps(), _CMP_LT_OQ));
+		}
+		const int mask = _mm256_movemask_ps(outside);
+		for (int k = 0; k < 8; k++) {
+			visible[i + k] = ((mask >> k) & 1) == 0;
+			inside += visible[i + k];
+		}
+	}
+#elif defined(FRUSTUM_SSE)
+	for (; i + 4 <= count; i += 4) {
+		__m128 outside = _mm_setzero_ps();
+		for (int p = 0; p < PlaneCount; p++) {
+			__m128 distance = _mm_set1_ps(Planes[p].w);
+			for (int axis = 0; axis < 3; axis++) {
+				distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(Planes[p][axis]),
+					_mm_loadu_ps(corners[p][axis] + i)));
+			}
+			outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, _mm_setzero_ps()));
+		}
+		const int mask = _mm_movemask_ps(outside);
+		for (int k = 0; k < 4; k++) {
+			visible[i + k] = ((mask >> k) & 1) == 0;
+			inside += visible[i + k];
+		}
+	}
+#endif
+	//the boxes left over from the batches, or all of them without SIMD
+	for (; i < count; i++) {
+		bool outside = false;
+		for (int p = 0; p < PlaneCount; p++) {
+			const float distance = Planes[p].x * corners[p][0][i] + Planes[p].y * corners[p][1][i]
+				+ Planes[p].z * corners[p][2][i] + Planes[p].w;
+			outside = outside || distance < 0.0f;
+		}
+		visible[i] = !outside;
+		inside += visible[i];
+	}
+	return inside;
+}
@@ -0,0 +1,68 @@
+#ifndef FRUSTUMPLANES_H_
+#define FRUSTUMPLANES_H_
+
+#include "glm/glm.hpp"
+#include "array"
+#include "vector"
+
+// =============================================================================
+// BoundingBoxes
+// =============================================================================
+// Axis aligned boxes kept as one array per coordinate of their corners, so a
+// batch of them can be tested against the frustum several boxes at a time.
+class BoundingBoxes
+{
+public:
+	// Add a box, returns its index
+	size_t Add(const glm::vec3& min, const glm::vec3& max);
+	void Set(size_t index, const glm::vec3& min, const glm::vec3& max);
+	void Clear();
+
+	glm::vec3 GetMin(size_t index) const { return glm::vec3(Min[0][index], Min[1][index], Min[2][index]); }
+	glm::vec3 GetMax(size_t index) const { return glm::vec3(Max[0][index], Max[1][index], Max[2][index]); }
+	inline size_t GetCount() const { return Min[0].size(); }
+
+	// The corners along one axis of every box
+	inline const float* GetMins(int axis) const { return Min[axis].data(); }
+	inline const float* GetMaxs(int axis) const { return Max[axis].data(); }
+
+private:
+	std::array<std::vector<float>, 3> Min;
+	std::array<std::vector<float>, 3> Max;
+};
+
+// =============================================================================
+// FrustumPlanes
+// =============================================================================
+// The six planes around what a view-projection matrix shows, pointing
+// inwards. A box is only outside if it is entirely behind one of the planes,
+// so a few boxes close to the corners of the frustum are kept even if they
+// can not be seen, but nothing that can be seen is ever thrown away.
+class FrustumPlanes
+{
+public:
+	enum Plane { Left, Right, Bottom, Top, Near, Far, PlaneCount };
+
+	// Planes that have everything inside them
+	FrustumPlanes() = default;
+	// The planes of what the matrix projects into clip space
+	explicit FrustumPlanes(const glm::mat4& viewProjection);
+
+	// The same planes in the space a model matrix maps to the world, to test
+	// boxes given before the model matrix
+	FrustumPlanes Transformed(const glm::mat4& model) const;
+
+	// Is any part of the box inside the frustum
+	bool IsVisible(const glm::vec3& min, const glm::vec3& max) const;
+	// Tests every box, visible[i] is set to 1 if box i is inside and to 0 if
+	// it is not. Returns the number of visible boxes.
+	size_t TestBoxes(const BoundingBoxes& boxes, std::vector<unsigned char>& visible) const;
+
+	// a, b, c and d of the plane ax + by + cz + d = 0
+	inline const glm::vec4& GetPlane(Plane plane) const { return Planes[plane]; }
+
+private:
+	std::array<glm::vec4, PlaneCount> Planes{};
+};
+
+#endif // FRUSTUMPLANES_H_
@@ -17,4 +17,11 @@ void IndexBuffer::Bind() const {
 // Unbind the Index buffer
 void IndexBuffer::Unbind() const {
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-}
\ No newline at end of file
+}
+
+// Replace the indices
+void IndexBuffer::BufferData(const GLuint* indices, GLsizei count) {
+	Count = count;
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, IndexBufferID);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, count * sizeof(GLuint), indices, GL_STATIC_DRAW);
+}
@@ -19,6 +19,11 @@ public:
 	// Unbind the vertex buffer
 	void Unbind() const;
 
+	// Replace the indices, reallocating the store to the new count. The
+	// element buffer binding is part of the bound vertex array, so bind the
+	// one owning this buffer first
+	void BufferData(const GLuint* indices, GLsizei count);
+
 	// Get the number of elements
 	inline GLuint GetCount() const { return Count; }
 
@@ -0,0 +1,59 @@
+#include "IndirectBuffer.h"
+#include "RenderCommands.h"
+
+#include <algorithm>
+#include <cstring>
+
+IndirectBuffer::IndirectBuffer() {
+	glGenBuffers(1, &IndirectBufferID);
+}
+IndirectBuffer::~IndirectBuffer() {
+	RenderCommands::ForgetIndirectBuffer(IndirectBufferID);
+	glDeleteBuffers(1, &IndirectBufferID);
+}
+
+// Add a command, returns its index
+GLuint IndirectBuffer::Add(const DrawElementsIndirectCommand& command) {
+	Commands.push_back(command);
+	const GLuint index = static_cast<GLuint>(Commands.size() - 1);
+	DirtyBegin = DirtyBegin < DirtyEnd ? std::min(DirtyBegin, index) : index;
+	DirtyEnd = index + 1;
+	return index;
+}
+
+// Replace a command, only a command that changes is uploaded again
+void IndirectBuffer::Set(GLuint index, const DrawElementsIndirectCommand& command) {
+	if (std::memcmp(&Commands[index], &command, sizeof(command)) == 0)
+		return;
+	Commands[index] = command;
+	DirtyBegin = DirtyBegin < DirtyEnd ? std::min(DirtyBegin, index) : index;
+	DirtyEnd = std::max(DirtyEnd, index + 1);
+}
+
+// Copy the commands that changed since the last upload to the GPU
+void IndirectBuffer::Upload() {
+	if (DirtyBegin >= DirtyEnd)
+		return;
+	RenderCommands::BindIndirectBuffer(IndirectBufferID);
+	const GLsizeiptr size = sizeof(DrawElementsIndirectCommand);
+	if (static_cast<GLsizeiptr>(Commands.size()) > Capacity) {
+		//grows to fit every command and sends all of them
+		Capacity = Commands.size();
+		glBufferData(GL_DRAW_INDIRECT_BUFFER, Capacity * size, Commands.data(), GL_DYNAMIC_DRAW);
+	}
+	else {
+		glBufferSubData(GL_DRAW_INDIRECT_BUFFER, DirtyBegin * size, (DirtyEnd - DirtyBegin) * size,
+			&Commands[DirtyBegin]);
+	}
+	DirtyBegin = DirtyEnd = 0;
+}
+
+// Bind the buffer as the indirect draw buffer
+void IndirectBuffer::Bind() const {
+	RenderCommands::BindIndirectBuffer(IndirectBufferID);
+}
+
+// Bind the buffer to a shader storage binding point
+void IndirectBuffer::BindStorage(GLuint binding) const {
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, IndirectBufferID);
+}
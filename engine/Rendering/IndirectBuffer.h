@@ -0,0 +1,60 @@
+#ifndef INDIRECTBUFFER_H_
+#define INDIRECTBUFFER_H_
+
+#include <glad/glad.h>
+#include "vector"
+
+// =============================================================================
+// DrawElementsIndirectCommand
+// =============================================================================
+// One draw as glMultiDrawElementsIndirect reads it from the indirect buffer
+struct DrawElementsIndirectCommand
+{
+	GLuint Count;			// indices of each instance
+	GLuint InstanceCount;
+	GLuint FirstIndex;
+	GLint BaseVertex;
+	GLuint BaseInstance;
+};
+
+// =============================================================================
+// IndirectBuffer
+// =============================================================================
+// Draw commands kept on the CPU and copied to a GL_DRAW_INDIRECT_BUFFER when
+// they change, so a group of draws sharing the same state is submitted with
+// one multi-draw call. The shaders tell the draws of a call apart by
+// gl_DrawID.
+class IndirectBuffer
+{
+public:
+	IndirectBuffer();
+	~IndirectBuffer();
+
+	IndirectBuffer(const IndirectBuffer&) = delete;
+	IndirectBuffer& operator=(const IndirectBuffer&) = delete;
+
+	// Add a command, returns its index
+	GLuint Add(const DrawElementsIndirectCommand& command);
+	// Replace a command, only a command that changes is uploaded again
+	void Set(GLuint index, const DrawElementsIndirectCommand& command);
+	// Copy the commands that changed since the last upload to the GPU
+	void Upload();
+
+	// Bind the buffer as the indirect draw buffer
+	void Bind() const;
+	// Bind the buffer to a shader storage binding point, for commands a
+	// compute shader writes. Only what was uploaded has room in the buffer.
+	void BindStorage(GLuint binding) const;
+	inline GLuint GetID() const { return IndirectBufferID; }
+	inline GLsizei GetCount() const { return static_cast<GLsizei>(Commands.size()); }
+	inline const DrawElementsIndirectCommand& GetCommand(GLuint index) const { return Commands[index]; }
+
+private:
+	GLuint IndirectBufferID;
+	std::vector<DrawElementsIndirectCommand> Commands;
+	GLsizeiptr Capacity = 0;		// commands the GPU buffer has room for
+	GLuint DirtyBegin = 0;
+	GLuint DirtyEnd = 0;
+};
+
+#endif // INDIRECTBUFFER_H_
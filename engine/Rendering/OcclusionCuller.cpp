@@ -0,0 +1,105 @@
+#include "OcclusionCuller.h"
+#include "RenderCommands.h"
+
+#include "glm/ext.hpp"
+
+namespace {
+	// Only the depth test of the boxes matters, the fragments write nothing
+	const std::string proxyVertexShader = R"(
+		#version 460 core
+		layout(location = 0) in vec3 position;
+		uniform mat4 u_proxyMatrix;
+		void main(){
+			gl_Position = u_proxyMatrix*vec4(position, 1.0);
+		}
+		)";
+	const std::string proxyFragmentShader = R"(
+		#version 460 core
+		void main(){
+		}
+		)";
+
+	// The box from 0,0,0 to 1,1,1
+	const float unitBox[] = {
+		0.0f, 0.0f, 0.0f,	1.0f, 0.0f, 0.0f,	1.0f, 1.0f, 0.0f,	0.0f, 1.0f, 0.0f,
+		0.0f, 0.0f, 1.0f,	1.0f, 0.0f, 1.0f,	1.0f, 1.0f, 1.0f,	0.0f, 1.0f, 1.0f
+	};
+	GLuint unitBoxTopology[] = {
+		0, 2, 1,	0, 3, 2,	//z = 0
+		4, 5, 6,	4, 6, 7,	//z = 1
+		0, 1, 5,	0, 5, 4,	//y = 0
+		3, 6, 2,	3, 7, 6,	//y = 1
+		0, 4, 7,	0, 7, 3,	//x = 0
+		1, 2, 6,	1, 6, 5		//x = 1
+	};
+}
+
+OcclusionCuller::OcclusionCuller(size_t count, float margin)
+	: Queries(count), Pending(count, 0), Visible(count, 1), Margin(margin) {
+	glGenQueries(static_cast<GLsizei>(count), Queries.data());
+
+	ProxyShader = std::make_shared<Shader>(proxyVertexShader, proxyFragmentShader);
+	ProxyMatrix = ProxyShader->Uniform<glm::mat4>("u_proxyMatrix");
+	auto vertices = std::make_shared<VertexBuffer>(unitBox, sizeof(unitBox));
+	vertices->SetLayout(BufferLayout({ {ShaderDataType::Float3, "position"} }));
+	ProxyBox = std::make_shared<VertexArray>();
+	ProxyBox->AddVertexBuffer(vertices);
+	ProxyBox->SetIndexBuffer(std::make_shared<IndexBuffer>(unitBoxTopology,
+		static_cast<GLsizei>(sizeof(unitBoxTopology) / sizeof(unitBoxTopology[0]))));
+}
+
+OcclusionCuller::~OcclusionCuller() {
+	glDeleteQueries(static_cast<GLsizei>(Queries.size()), Queries.data());
+}
+
+void OcclusionCuller::Collect() {
+	for (size_t i = 0; i < Queries.size(); i++) {
+		if (!Pending[i])
+			continue;
+		GLuint available = GL_FALSE;
+		glGetQueryObjectuiv(Queries[i], GL_QUERY_RESULT_AVAILABLE, &available);
+		if (available == GL_FALSE)
+			continue;
+		GLuint passed = GL_TRUE;
+		glGetQueryObjectuiv(Queries[i], GL_QUERY_RESULT, &passed);
+		Visible[i] = passed != GL_FALSE;
+		Pending[i] = 0;
+	}
+}
+
+void OcclusionCuller::Test(const BoundingBoxes& boxes, const std::vector<unsigned char>& candidates,
+	const glm::mat4& viewProjection, const glm::vec3& eye) {
+	ProxyShader->Bind();
+	ProxyBox->Bind();
+	RenderCommands::SetColorMask(false);
+	RenderCommands::SetDepthMask(false);
+	RenderCommands::SetDepthTest(true);
+	RenderCommands::SetPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+
+	QueryCount = 0;
+	for (size_t i = 0; i < Queries.size(); i++) {
+		if (!candidates[i]) {
+			Visible[i] = 1;
+			continue;
+		}
+		if (Pending[i])
+			continue;
+		const glm::vec3 min = boxes.GetMin(i) - glm::vec3(Margin);
+		const glm::vec3 max = boxes.GetMax(i) + glm::vec3(Margin);
+		//the near plane would cut away the front of a box the camera is in
+		if (glm::all(glm::greaterThanEqual(eye, min)) && glm::all(glm::lessThanEqual(eye, max))) {
+			Visible[i] = 1;
+			continue;
+		}
+		ProxyMatrix.Set(viewProjection * glm::translate(glm::mat4(1.0f), min)
+			* glm::scale(glm::mat4(1.0f), max - min));
+		glBeginQuery(GL_ANY_SAMPLES_PASSED_CONSERVATIVE, Queries[i]);
+		RenderCommands::DrawIndex(ProxyBox, GL_TRIANGLES);
+		glEndQuery(GL_ANY_SAMPLES_PASSED_CONSERVATIVE);
+		Pending[i] = 1;
+		QueryCount++;
+	}
+
+	RenderCommands::SetColorMask(true);
+	RenderCommands::SetDepthMask(true);
+}
@@ -0,0 +1,60 @@
+#ifndef OCCLUSIONCULLER_H_
+#define OCCLUSIONCULLER_H_
+
+#include <glad/glad.h>
+#include "glm/glm.hpp"
+#include "FrustumPlanes.h"
+#include "Shader.h"
+#include "VertexArray.h"
+#include "memory"
+#include "vector"
+
+// =============================================================================
+// OcclusionCuller
+// =============================================================================
+// Finds the boxes that are hidden behind what was already drawn. The box of
+// every candidate is drawn without touching the color or depth buffer inside
+// a GL_ANY_SAMPLES_PASSED_CONSERVATIVE query, after the opaque geometry of
+// the frame. The results are only read once the GPU has them, a frame or more
+// later, so the CPU never waits on a query: a box counts as visible until its
+// first result comes back and keeps its last result while a query is in
+// flight.
+class OcclusionCuller
+{
+public:
+	// count - number of boxes
+	// margin - how much the boxes are grown on each side before they are
+	//		drawn, so a box is not hidden by the geometry inside it
+	OcclusionCuller(size_t count, float margin);
+	~OcclusionCuller();
+
+	OcclusionCuller(const OcclusionCuller&) = delete;
+	OcclusionCuller& operator=(const OcclusionCuller&) = delete;
+
+	// Reads the results that came back since the last call
+	void Collect();
+	// Was box i visible the last time it was tested
+	inline bool IsVisible(size_t index) const { return Visible[index] != 0; }
+
+	// Draws the boxes with candidates[i] set that are not waiting for a
+	// result. The others are visible from now on, until they are tested.
+	// viewProjection - from the space of the boxes to clip space
+	// eye - the camera in the space of the boxes, boxes around it are visible
+	void Test(const BoundingBoxes& boxes, const std::vector<unsigned char>& candidates,
+		const glm::mat4& viewProjection, const glm::vec3& eye);
+
+	// Queries issued by the last Test
+	inline size_t GetQueryCount() const { return QueryCount; }
+
+private:
+	std::vector<GLuint> Queries;
+	std::vector<unsigned char> Pending;	// the query was issued and not read yet
+	std::vector<unsigned char> Visible;
+	float Margin;
+	size_t QueryCount = 0;
+	std::shared_ptr<Shader> ProxyShader;
+	std::shared_ptr<VertexArray> ProxyBox;
+	UniformHandle<glm::mat4> ProxyMatrix;
+};
+
+#endif // OCCLUSIONCULLER_H_
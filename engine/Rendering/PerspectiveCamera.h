@@ -30,10 +30,7 @@ public:
         CameraFrustrum = frustrum;
         CameraFrustrum.height = height;
         CameraFrustrum.width = width;
-        Camera::ViewMatrix = glm::lookAt(position, lookAt, upVector);
-        Camera::ProjectionMatrix = glm::perspective(glm::radians(CameraFrustrum.angle),
-            CameraFrustrum.width / CameraFrustrum.height, CameraFrustrum.near, CameraFrustrum.far);
-        Camera::ViewProjectionMatrix = Camera::ProjectionMatrix * Camera::ViewMatrix;
+        RecalculateMatrix();
     }
     ~PerspectiveCamera() = default;
     PerspectiveCamera(const PerspectiveCamera& camera) : Camera(camera)
@@ -63,6 +60,7 @@ protected:
         Camera::ViewMatrix = glm::lookAt(Camera::Position, LookAt, UpVector);
         Camera::ProjectionMatrix = glm::perspective(glm::radians(CameraFrustrum.angle), CameraFrustrum.width / CameraFrustrum.height, CameraFrustrum.near, CameraFrustrum.far);
         Camera::ViewProjectionMatrix =  Camera::ProjectionMatrix * Camera::ViewMatrix;
+        Camera::Frustum = FrustumPlanes(Camera::ViewProjectionMatrix);
     }
 
 protected:
@@ -0,0 +1,126 @@
+#include "ProgramCache.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+namespace {
+	// At the start of every file, before the binary
+	struct BinaryHeader
+	{
+		char Magic[4];
+		GLenum Format;			// as glGetProgramBinary gave it
+		std::uint32_t Length;	// bytes after the header
+	};
+	constexpr char BinaryMagic[4] = { 'B', 'O', 'P', '1' };
+
+	// FNV-1a, carried on from the hash so far
+	std::uint64_t Hash(std::string_view data, std::uint64_t hash) {
+		for (unsigned char c : data) {
+			hash ^= c;
+			hash *= 1099511628211ull;
+		}
+		return hash;
+	}
+
+	std::string GLString(GLenum name) {
+		const GLubyte* value = glGetString(name);
+		return value != nullptr ? reinterpret_cast<const char*>(value) : "";
+	}
+}
+
+void ProgramCache::SetDirectory(const std::string& directory) {
+	Directory = directory;
+}
+
+bool ProgramCache::IsEnabled() {
+	if (Directory.empty())
+		return false;
+	//some drivers have no binary formats at all
+	GLint formats = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+	return formats > 0;
+}
+
+std::string ProgramCache::KeyOf(std::initializer_list<std::string_view> sources) {
+	if (Driver.empty())
+		Driver = GLString(GL_RENDERER) + "\n" + GLString(GL_VERSION);
+	std::uint64_t hash = Hash(Driver, 14695981039346656037ull);
+	for (std::string_view source : sources) {
+		//the length keeps two sources from hashing as one
+		hash = Hash(std::to_string(source.size()) + "\n", hash);
+		hash = Hash(source, hash);
+	}
+	static const char digits[] = "0123456789abcdef";
+	std::string key(16, '0');
+	for (int i = 15; i >= 0; i--, hash >>= 4)
+		key[i] = digits[hash & 0xf];
+	return key;
+}
+
+bool ProgramCache::Load(GLuint program, const std::string& key) {
+	std::ifstream file(std::filesystem::path(Directory) / (key + ".bin"), std::ios::binary | std::ios::ate);
+	const std::streamoff fileSize = file ? static_cast<std::streamoff>(file.tellg()) : 0;
+	file.seekg(0);
+	BinaryHeader header{};
+	std::vector<char> binary;
+	//the length is only trusted as far as the file goes, a broken or foreign
+	// file is a miss like a missing one
+	if (file.read(reinterpret_cast<char*>(&header), sizeof(header))
+		&& std::equal(header.Magic, header.Magic + 4, BinaryMagic)
+		&& header.Length <= static_cast<std::uint64_t>(fileSize) - sizeof(header)) {
+		binary.resize(header.Length);
+		if (!file.read(binary.data(), binary.size()))
+			binary.clear();
+	}
+	if (binary.empty()) {
+		Misses++;
+		return false;
+	}
+
+	glProgramBinary(program, header.Format, binary.data(), static_cast<GLsizei>(binary.size()));
+	GLint status = GL_FALSE;
+	glGetProgramiv(program, GL_LINK_STATUS, &status);
+	if (status != GL_TRUE) {
+		//an old binary the driver no longer takes, it is replaced once the
+		// program is compiled
+		Misses++;
+		return false;
+	}
+	Hits++;
+	return true;
+}
+
+void ProgramCache::Store(GLuint program, const std::string& key) {
+	GLint length = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0)
+		return;
+	BinaryHeader header{ { BinaryMagic[0], BinaryMagic[1], BinaryMagic[2], BinaryMagic[3] }, 0, 0 };
+	std::vector<char> binary(length);
+	GLsizei written = 0;
+	glGetProgramBinary(program, length, &written, &header.Format, binary.data());
+	header.Length = static_cast<std::uint32_t>(written);
+
+	//written next to the binary and renamed, so another instance starting
+	// at the same time never reads half a file
+	std::error_code error;
+	std::filesystem::create_directories(Directory, error);
+	const std::filesystem::path path = std::filesystem::path(Directory) / (key + ".bin");
+	std::filesystem::path partial = path;
+	partial += ".part";
+	{
+		std::ofstream file(partial, std::ios::binary | std::ios::trunc);
+		if (!file.write(reinterpret_cast<const char*>(&header), sizeof(header))
+			|| !file.write(binary.data(), written)) {
+			std::cerr << "Could not write the shader cache file " << partial.string() << "\n";
+			return;
+		}
+	}
+	std::filesystem::rename(partial, path, error);
+	if (error)
+		std::cerr << "Could not write the shader cache file " << path.string() << ": " << error.message() << "\n";
+}
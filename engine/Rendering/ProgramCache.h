@@ -0,0 +1,46 @@
+#ifndef PROGRAMCACHE_H_
+#define PROGRAMCACHE_H_
+
+#include <glad/glad.h>
+#include "initializer_list"
+#include "string"
+#include "string_view"
+
+// =============================================================================
+// ProgramCache
+// =============================================================================
+// Linked shader programs kept on disk with glGetProgramBinary, so the next
+// start loads them with glProgramBinary instead of compiling the sources
+// again. A binary is found by a hash of the sources together with GL_RENDERER
+// and GL_VERSION, so a changed shader or another driver makes a new one. A
+// binary the driver does not take is not used, the program is compiled and
+// the binary replaced. The cache is off until a directory is set.
+class ProgramCache
+{
+public:
+	// Where the binaries are kept, the directory is made when the first one
+	// is stored. An empty path turns the cache off.
+	static void SetDirectory(const std::string& directory);
+	static bool IsEnabled();
+
+	// Name of the binary of a program linked from the sources, in the order
+	// they are given. Needs the GL context.
+	static std::string KeyOf(std::initializer_list<std::string_view> sources);
+	// Loads the binary into the program, returns true if it is linked
+	static bool Load(GLuint program, const std::string& key);
+	// Writes the binary of a linked program, made with
+	// GL_PROGRAM_BINARY_RETRIEVABLE_HINT set
+	static void Store(GLuint program, const std::string& key);
+
+	// Programs loaded from the cache and programs that had to be compiled
+	static unsigned int GetHits() { return Hits; }
+	static unsigned int GetMisses() { return Misses; }
+
+private:
+	inline static std::string Directory;
+	inline static std::string Driver;	// GL_RENDERER and GL_VERSION, asked for once
+	inline static unsigned int Hits = 0;
+	inline static unsigned int Misses = 0;
+};
+
+#endif // PROGRAMCACHE_H_
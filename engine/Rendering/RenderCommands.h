@@ -3,13 +3,129 @@
 
 #include "glad/glad.h"
 #include "VertexArray.h"
+#include "IndirectBuffer.h"
 
 
 namespace RenderCommands
 {
+	// =========================================================================
+	// State tracking
+	// =========================================================================
+	// The GL state set through RenderCommands is shadowed here, and calls
+	// that would set it to what it already is are never made. Anything that
+	// changes the same state with GL directly must call ResetState after.
+	constexpr GLuint UnknownState = ~0u;
+	constexpr GLuint MaxTextureUnits = 32;
+
+	// How many state changes were sent to GL and how many were skipped
+	struct StateStats
+	{
+		unsigned long long issued = 0;
+		unsigned long long filtered = 0;
+	};
+
+	struct StateCache
+	{
+		GLuint program = UnknownState;
+		GLuint vertexArray = UnknownState;
+		GLuint indirectBuffer = UnknownState;
+		GLuint activeTextureUnit = UnknownState;
+		GLuint textures[MaxTextureUnits];
+		GLuint blend = UnknownState;		// 0 or 1
+		GLuint depthTest = UnknownState;	// 0 or 1
+		GLuint depthMask = UnknownState;	// 0 or 1
+		GLuint colorMask = UnknownState;	// 0 or 1, for all four channels
+		GLenum polygonMode = UnknownState;
+		StateStats stats;
+
+		StateCache() { for (auto& texture : textures) texture = UnknownState; }
+	};
+
+	inline StateCache State;
+
+	// Returns true if the shadowed value is already the one asked for,
+	// otherwise stores it and counts the call that is about to be made
+	inline bool Filter(GLuint& shadowed, GLuint value) {
+		if (shadowed == value) {
+			State.stats.filtered++;
+			return true;
+		}
+		shadowed = value;
+		State.stats.issued++;
+		return false;
+	}
+
+	// Forget everything, the next call of each kind is always made
+	inline void ResetState() {
+		StateStats stats = State.stats;
+		State = StateCache();
+		State.stats = stats;
+	}
+	inline const StateStats& GetStateStats() { return State.stats; }
+
+	inline void UseProgram(GLuint program) { if (!Filter(State.program, program)) glUseProgram(program); }
+	inline void BindVertexArray(GLuint vertexArray) { if (!Filter(State.vertexArray, vertexArray)) glBindVertexArray(vertexArray); }
+	inline void BindIndirectBuffer(GLuint buffer) { if (!Filter(State.indirectBuffer, buffer)) glBindBuffer(GL_DRAW_INDIRECT_BUFFER, buffer); }
+	inline void ActiveTexture(GLuint unit) { if (!Filter(State.activeTextureUnit, unit)) glActiveTexture(GL_TEXTURE0 + unit); }
+	// Binds a texture to a texture unit, the unit is left active. Units past
+	// the shadowed ones are always bound
+	inline void BindTexture(GLuint unit, GLenum target, GLuint texture) {
+		ActiveTexture(unit);
+		if (unit < MaxTextureUnits && Filter(State.textures[unit], texture))
+			return;
+		glBindTexture(target, texture);
+	}
+	inline void SetBlend(bool enabled) { if (!Filter(State.blend, enabled)) { if (enabled) glEnable(GL_BLEND); else glDisable(GL_BLEND); } }
+	inline void SetDepthTest(bool enabled) { if (!Filter(State.depthTest, enabled)) { if (enabled) glEnable(GL_DEPTH_TEST); else glDisable(GL_DEPTH_TEST); } }
+	inline void SetDepthMask(bool enabled) { if (!Filter(State.depthMask, enabled)) glDepthMask(enabled ? GL_TRUE : GL_FALSE); }
+	inline void SetColorMask(bool enabled) {
+		if (!Filter(State.colorMask, enabled)) {
+			const GLboolean mask = enabled ? GL_TRUE : GL_FALSE;
+			glColorMask(mask, mask, mask, mask);
+		}
+	}
+	inline void SetPolygonMode(GLenum face, GLenum mode) {
+		//the core profile only has GL_FRONT_AND_BACK, anything else is passed on
+		if (face != GL_FRONT_AND_BACK) {
+			State.polygonMode = UnknownState;
+			glPolygonMode(face, mode);
+		}
+		else if (!Filter(State.polygonMode, mode))
+			glPolygonMode(face, mode);
+	}
+
+	// Objects that are deleted while bound must be forgotten, a new object
+	// may get the same name
+	inline void ForgetProgram(GLuint program) { if (State.program == program) State.program = UnknownState; }
+	inline void ForgetVertexArray(GLuint vertexArray) { if (State.vertexArray == vertexArray) State.vertexArray = UnknownState; }
+	inline void ForgetIndirectBuffer(GLuint buffer) { if (State.indirectBuffer == buffer) State.indirectBuffer = UnknownState; }
+	inline void ForgetTexture(GLuint texture) {
+		for (GLuint& bound : State.textures) {
+			if (bound == texture)
+				bound = UnknownState;
+		}
+	}
+
 	inline void Clear(GLuint mode = GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT) { glClear(mode); };
-	inline void SetPolygonMode(GLenum face, GLenum mode) { glPolygonMode(face, mode); }
 	inline void DrawIndex(const std::shared_ptr<VertexArray>& vao, GLenum primitive) { glDrawElements(primitive, vao->GetIndexBuffer()->GetCount(), GL_UNSIGNED_INT, nullptr); }
+	// Draws the indices of the vertex array once for each instance, the vertex buffers added
+	// with a divisor give the data of each instance starting at baseInstance
+	inline void DrawIndexInstanced(const std::shared_ptr<VertexArray>& vao, GLenum primitive, GLsizei instances, GLuint baseInstance = 0) { glDrawElementsInstancedBaseInstance(primitive, vao->GetIndexBuffer()->GetCount(), GL_UNSIGNED_INT, nullptr, instances, baseInstance); }
+	// Draws count commands of the indirect buffer starting at first with the bound vertex
+	// array, in one call. The shaders see the index of each command from first as gl_DrawID
+	inline void MultiDrawIndexIndirect(const IndirectBuffer& commands, GLenum primitive, GLuint first, GLsizei count) {
+		commands.Bind();
+		glMultiDrawElementsIndirect(primitive, GL_UNSIGNED_INT,
+			reinterpret_cast<const void*>(first * sizeof(DrawElementsIndirectCommand)), count, 0);
+	}
+	// Like MultiDrawIndexIndirect from the first command, but how many are drawn is the GLuint
+	// at the start of countBuffer, so a compute shader can write it. At most maxCount are drawn
+	inline void MultiDrawIndexIndirectCount(const IndirectBuffer& commands, GLuint countBuffer,
+		GLenum primitive, GLsizei maxCount) {
+		commands.Bind();
+		glBindBuffer(GL_PARAMETER_BUFFER, countBuffer);
+		glMultiDrawElementsIndirectCount(primitive, GL_UNSIGNED_INT, nullptr, 0, maxCount, 0);
+	}
 }
 
 
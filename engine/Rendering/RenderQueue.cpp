@@ -0,0 +1,99 @@
+#include "RenderQueue.h"
+#include "RenderCommands.h"
+
+#include <algorithm>
+
+namespace {
+	// Bits of each part of a key, from the top:
+	//   opaque:  blended(1) program(7) vertex array(7) line(1) depth(24) order(24)
+	//   blended: blended(1) far depth(24) program(7) vertex array(7) line(1) order(24)
+	constexpr int SlotBits = 7;
+	constexpr int DepthBits = 24;
+	constexpr int OrderBits = 24;
+	constexpr std::uint64_t SlotMask = (1ull << SlotBits) - 1;
+	constexpr std::uint64_t DepthMask = (1ull << DepthBits) - 1;
+	constexpr std::uint64_t OrderMask = (1ull << OrderBits) - 1;
+}
+
+void RenderQueue::Submit(const Packet& packet, std::initializer_list<MaterialUniform> material) {
+	if (UniformRanges.empty())
+		UniformRanges.push_back(0);
+	Packets.push_back(packet);
+	Uniforms.insert(Uniforms.end(), material.begin(), material.end());
+	UniformRanges.push_back(static_cast<std::uint32_t>(Uniforms.size()));
+}
+
+std::uint64_t RenderQueue::Slot(std::vector<const void*>& seen, const void* object) {
+	auto found = std::find(seen.begin(), seen.end(), object);
+	if (found != seen.end())
+		return static_cast<std::uint64_t>(found - seen.begin());
+	seen.push_back(object);
+	//past the last slot the packets are still drawn, just not grouped
+	return std::min<std::uint64_t>(seen.size() - 1, SlotMask);
+}
+
+std::uint64_t RenderQueue::MakeKey(const Packet& packet, std::uint32_t order, float nearest, float farthest) {
+	const std::uint64_t program = Slot(SeenPrograms, packet.Program.get());
+	const std::uint64_t vertexArray = Slot(SeenVertexArrays, packet.Vertices.get());
+	const std::uint64_t line = packet.PolygonMode == GL_LINE;
+	float range = farthest - nearest;
+	float depth = range > 0.0f ? (packet.Depth - nearest) / range : 0.0f;
+	std::uint64_t quantized = static_cast<std::uint64_t>(depth * DepthMask) & DepthMask;
+	std::uint64_t state = (program << (SlotBits + 1)) | (vertexArray << 1) | line;
+
+	if (!packet.Blend)
+		return (state << (DepthBits + OrderBits)) | (quantized << OrderBits) | (order & OrderMask);
+	//the farthest blended packets come first
+	quantized = DepthMask - quantized;
+	return (1ull << 63) | (quantized << (2 * SlotBits + 1 + OrderBits))
+		| (state << OrderBits) | (order & OrderMask);
+}
+
+void RenderQueue::Flush() {
+	float nearest = 0.0f;
+	float farthest = 0.0f;
+	for (size_t i = 0; i < Packets.size(); i++) {
+		nearest = i == 0 ? Packets[i].Depth : std::min(nearest, Packets[i].Depth);
+		farthest = i == 0 ? Packets[i].Depth : std::max(farthest, Packets[i].Depth);
+	}
+	SeenPrograms.clear();
+	SeenVertexArrays.clear();
+	Entries.clear();
+	for (std::uint32_t i = 0; i < Packets.size(); i++)
+		Entries.push_back({ MakeKey(Packets[i], i, nearest, farthest), i });
+	std::sort(Entries.begin(), Entries.end(),
+		[](const Entry& a, const Entry& b) { return a.Key < b.Key; });
+
+	for (const Entry& entry : Entries) {
+		const Packet& packet = Packets[entry.Packet];
+		packet.Program->Bind();
+		packet.Vertices->Bind();
+		RenderCommands::SetBlend(packet.Blend);
+		RenderCommands::SetDepthMask(packet.DepthWrite);
+		RenderCommands::SetPolygonMode(GL_FRONT_AND_BACK, packet.PolygonMode);
+		for (std::uint32_t u = UniformRanges[entry.Packet]; u < UniformRanges[entry.Packet + 1]; u++) {
+			const MaterialUniform& uniform = Uniforms[u];
+			std::visit([&uniform](const auto& value) {
+				UniformHandle<std::decay_t<decltype(value)>>(uniform.Location).Set(value);
+			}, uniform.Value);
+		}
+		if (packet.Indirect && packet.DrawCountBuffer != 0)
+			RenderCommands::MultiDrawIndexIndirectCount(*packet.Indirect, packet.DrawCountBuffer,
+				packet.Primitive, packet.CommandCount);
+		else if (packet.Indirect)
+			RenderCommands::MultiDrawIndexIndirect(*packet.Indirect, packet.Primitive,
+				packet.FirstCommand, packet.CommandCount);
+		else if (packet.Instances > 0)
+			RenderCommands::DrawIndexInstanced(packet.Vertices, packet.Primitive, packet.Instances,
+				packet.BaseInstance);
+		else
+			RenderCommands::DrawIndex(packet.Vertices, packet.Primitive);
+	}
+	DrawCount = Entries.size();
+
+	//the depth mask has to be on for the next glClear to clear depth
+	RenderCommands::SetDepthMask(true);
+	Packets.clear();
+	Uniforms.clear();
+	UniformRanges.clear();
+}
@@ -0,0 +1,87 @@
+#ifndef RENDERQUEUE_H_
+#define RENDERQUEUE_H_
+
+#include "glad/glad.h"
+#include "glm/glm.hpp"
+#include "Shader.h"
+#include "VertexArray.h"
+#include "cstdint"
+#include "initializer_list"
+#include "memory"
+#include "variant"
+#include "vector"
+
+// =============================================================================
+// RenderQueue
+// =============================================================================
+// Draws are submitted as packets during the frame and drawn together by Flush.
+// Every packet gets a 64 bit key and the packets are drawn in key order:
+// opaque ones first, grouped by shader and vertex array and front to back
+// inside a group, then the blended ones back to front. The state between two
+// packets is changed through RenderCommands, so only what differs is set.
+class RenderQueue
+{
+public:
+	// A uniform set before a packet is drawn, from a handle of its shader
+	struct MaterialUniform
+	{
+		template<typename T>
+		MaterialUniform(const UniformHandle<T>& handle, const T& value)
+			: Location(handle.GetLocation()), Value(value) {}
+
+		GLint Location;
+		std::variant<int, float, glm::vec2, glm::vec3, glm::vec4, glm::mat4> Value;
+	};
+
+	struct Packet
+	{
+		std::shared_ptr<Shader> Program;
+		std::shared_ptr<VertexArray> Vertices;
+		GLenum Primitive = GL_TRIANGLES;
+		GLsizei Instances = 0;			// 0 for a draw that is not instanced
+		GLuint BaseInstance = 0;		// first instance read, for streamed instance data
+		// Commands drawn with one multi-draw call instead of the draw above
+		std::shared_ptr<IndirectBuffer> Indirect;
+		GLuint FirstCommand = 0;
+		GLsizei CommandCount = 0;
+		// If set, the number of commands is read from the start of this
+		// buffer on the GPU and CommandCount is the most that are drawn
+		GLuint DrawCountBuffer = 0;
+		GLenum PolygonMode = GL_FILL;
+		bool Blend = false;				// alpha blended, drawn after the opaque ones
+		bool DepthWrite = true;
+		float Depth = 0.0f;				// distance from the camera, for the order
+	};
+
+public:
+	// Queue a draw with the uniforms that are set just before it
+	void Submit(const Packet& packet, std::initializer_list<MaterialUniform> material = {});
+	// Draw everything submitted since the last flush and empty the queue
+	void Flush();
+
+	// Draws the last flush made
+	inline std::size_t GetDrawCount() const { return DrawCount; }
+
+private:
+	struct Entry
+	{
+		std::uint64_t Key;
+		std::uint32_t Packet;
+	};
+
+	std::uint64_t MakeKey(const Packet& packet, std::uint32_t order, float nearest, float farthest);
+	// Small number standing for a shader or a vertex array in the keys
+	static std::uint64_t Slot(std::vector<const void*>& seen, const void* object);
+
+private:
+	std::vector<Packet> Packets;
+	// the uniforms of packet i are UniformRanges[i] to UniformRanges[i + 1]
+	std::vector<MaterialUniform> Uniforms;
+	std::vector<std::uint32_t> UniformRanges;
+	std::vector<Entry> Entries;
+	std::vector<const void*> SeenPrograms;
+	std::vector<const void*> SeenVertexArrays;
+	std::size_t DrawCount = 0;
+};
+
+#endif // RENDERQUEUE_H_
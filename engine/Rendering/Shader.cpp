@@ -1,67 +1,142 @@
 #include "Shader.h"
+#include "RenderCommands.h"
+#include "ProgramCache.h"
+
+#include "vector"
 
 Shader::Shader(const std::string& vertexSrc, const std::string& fragmentSrc) {
 	ShaderProgram = glCreateProgram();
-	CompileShader(GL_VERTEX_SHADER, vertexSrc);
-	CompileShader(GL_FRAGMENT_SHADER, fragmentSrc);
-	glAttachShader(ShaderProgram, VertexShader);
-	glAttachShader(ShaderProgram, FragmentShader);
-	glLinkProgram(ShaderProgram);
-
-	glDeleteShader(VertexShader);
-	glDeleteShader(FragmentShader);
-
-	
+	const std::string key = ProgramCache::IsEnabled() ? ProgramCache::KeyOf({ vertexSrc, fragmentSrc }) : "";
+	if (LoadCached(key))
+		return;
+	Link({ CompileShader(GL_VERTEX_SHADER, vertexSrc), CompileShader(GL_FRAGMENT_SHADER, fragmentSrc) }, key);
+}
+Shader::Shader(const std::string& computeSrc) {
+	ShaderProgram = glCreateProgram();
+	const std::string key = ProgramCache::IsEnabled() ? ProgramCache::KeyOf({ computeSrc }) : "";
+	if (LoadCached(key))
+		return;
+	Link({ CompileShader(GL_COMPUTE_SHADER, computeSrc) }, key);
 }
 Shader::~Shader() {
+	RenderCommands::ForgetProgram(ShaderProgram);
 	glDeleteProgram(ShaderProgram);
 }
 
 void Shader::Bind() const {
-	glUseProgram(ShaderProgram);
+	RenderCommands::UseProgram(ShaderProgram);
 }
 void Shader::Unbind() const {
-	glUseProgram(0);
+	RenderCommands::UseProgram(0);
+}
+void Shader::Dispatch(GLuint groupsX, GLuint groupsY, GLuint groupsZ) const {
+	Bind();
+	glDispatchCompute(groupsX, groupsY, groupsZ);
 }
 void Shader::UploadUniformFloat2(const std::string& name,
     const glm::vec2& vector) {
-	glUniform2f(glGetUniformLocation(ShaderProgram, name.c_str()), vector.x, vector.y);
+	glUniform2f(GetUniformLocation(name), vector.x, vector.y);
 }
 void Shader::UploadUniformFloat3(const std::string& name,
 	const glm::vec3& vector) {
-	glUniform3f(glGetUniformLocation(ShaderProgram, name.c_str()), vector.x, vector.y,vector.z);
+	glUniform3f(GetUniformLocation(name), vector.x, vector.y,vector.z);
 }
 void Shader::UploadUniformFloat4(const std::string& name,
 	const glm::vec4& vector) {
-	glUniform4f(glGetUniformLocation(ShaderProgram, name.c_str()), vector[0], vector[1],vector[2],vector[3]);
+	glUniform4f(GetUniformLocation(name), vector[0], vector[1],vector[2],vector[3]);
 }
 
 void Shader::UploadUniformMat4x4(const std::string& name,
 	const glm::mat4& mat) {
-	glUniformMatrix4fv(glGetUniformLocation(ShaderProgram, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+	glUniformMatrix4fv(GetUniformLocation(name), 1, GL_FALSE, &mat[0][0]);
 
 }
 void Shader::UploadUniformInt(const std::string& name,
 	const int integer) {
-	glUniform1i(glGetUniformLocation(ShaderProgram, name.c_str()), integer);
+	glUniform1i(GetUniformLocation(name), integer);
 }
 void Shader::UploadUniformFloat(const std::string& name,
 	const float flpt) {
-	glUniform1f(glGetUniformLocation(ShaderProgram, name.c_str()), flpt);
+	glUniform1f(GetUniformLocation(name), flpt);
 }
 
-void Shader::CompileShader(GLenum shaderType, const std::string& shaderSrc) {
+GLint Shader::GetUniformLocation(const std::string& name) const {
+	auto location = UniformLocations.find(name);
+	return location != UniformLocations.end() ? location->second : -1;
+}
 
-	if (shaderType == GL_VERTEX_SHADER) {
-		VertexShader = glCreateShader(shaderType);
-		const GLchar* src = shaderSrc.c_str();
-		glShaderSource(VertexShader, 1, &src, nullptr);
-		glCompileShader(VertexShader);
+void Shader::CacheUniformLocations() {
+	GLint count = 0;
+	GLint maxLength = 0;
+	glGetProgramiv(ShaderProgram, GL_ACTIVE_UNIFORMS, &count);
+	glGetProgramiv(ShaderProgram, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+	std::vector<GLchar> name(maxLength + 1, '\0');
+	for (GLint i = 0; i < count; i++) {
+		GLsizei length = 0;
+		GLint size = 0;
+		GLenum type = 0;
+		glGetActiveUniform(ShaderProgram, i, maxLength, &length, &size, &type, name.data());
+		std::string uniform(name.data(), length);
+		GLint location = glGetUniformLocation(ShaderProgram, uniform.c_str());
+		//uniforms in blocks have no location
+		if (location < 0)
+			continue;
+		UniformLocations[uniform] = location;
+		//arrays are listed as name[0], they can be set by the plain name too
+		if (uniform.size() > 3 && uniform.compare(uniform.size() - 3, 3, "[0]") == 0)
+			UniformLocations[uniform.substr(0, uniform.size() - 3)] = location;
 	}
-	else {
-		FragmentShader = glCreateShader(shaderType);
-		const GLchar* src = shaderSrc.c_str();
-		glShaderSource(FragmentShader, 1, &src, nullptr);
-		glCompileShader(FragmentShader);
+}
+
+bool Shader::LoadCached(const std::string& cacheKey) {
+	if (cacheKey.empty() || !ProgramCache::Load(ShaderProgram, cacheKey))
+		return false;
+	Linked = true;
+	CacheUniformLocations();
+	return true;
+}
+
+void Shader::Link(std::initializer_list<GLuint> shaders, const std::string& cacheKey) {
+	if (!cacheKey.empty())
+		glProgramParameteri(ShaderProgram, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	glLinkProgram(ShaderProgram);
+	for (GLuint shader : shaders)
+		glDeleteShader(shader);
+
+	GLint status = GL_FALSE;
+	glGetProgramiv(ShaderProgram, GL_LINK_STATUS, &status);
+	Linked = status == GL_TRUE;
+	if (!Linked) {
+		GLint length = 0;
+		glGetProgramiv(ShaderProgram, GL_INFO_LOG_LENGTH, &length);
+		std::vector<GLchar> log(length + 1, '\0');
+		glGetProgramInfoLog(ShaderProgram, length, nullptr, log.data());
+		std::cerr << "Shader program failed to link:\n" << log.data() << "\n";
+		return;
+	}
+	CacheUniformLocations();
+	if (!cacheKey.empty())
+		ProgramCache::Store(ShaderProgram, cacheKey);
+}
+
+GLuint Shader::CompileShader(GLenum shaderType, const std::string& shaderSrc) {
+
+	GLuint shader = glCreateShader(shaderType);
+	const GLchar* src = shaderSrc.c_str();
+	glShaderSource(shader, 1, &src, nullptr);
+	glCompileShader(shader);
+	glAttachShader(ShaderProgram, shader);
+
+	GLint status = GL_FALSE;
+	glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+	if (status != GL_TRUE) {
+		GLint length = 0;
+		glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &length);
+		std::vector<GLchar> log(length + 1, '\0');
+		glGetShaderInfoLog(shader, length, nullptr, log.data());
+		std::cerr << (shaderType == GL_VERTEX_SHADER ? "Vertex"
+			: shaderType == GL_FRAGMENT_SHADER ? "Fragment" : "Compute")
+			<< " shader failed to compile:\n" << log.data() << "\n";
 	}
+	return shader;
 }
\ No newline at end of file
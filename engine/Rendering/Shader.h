@@ -2,16 +2,61 @@
 #define SHADER_H_
 
 #include "iostream"
+#include "initializer_list"
+#include "string"
+#include "unordered_map"
 #include "glad/glad.h"
 #include "glm/glm.hpp"
+
+// =============================================================================
+// UniformHandle
+// =============================================================================
+// A uniform of a shader found once by name, setting it does no lookup at all.
+// Like the Upload functions it sets the uniform of the bound shader.
+// Handles of uniforms the shader does not have are ignored when set.
+template<typename T>
+class UniformHandle
+{
+public:
+    UniformHandle() = default;
+    explicit UniformHandle(GLint location) : Location(location) {}
+
+    void Set(const T& value) const;
+
+    bool IsValid() const { return Location >= 0; }
+    GLint GetLocation() const { return Location; }
+
+private:
+    GLint Location = -1;
+};
+
+template<> inline void UniformHandle<int>::Set(const int& value) const { glUniform1i(Location, value); }
+template<> inline void UniformHandle<float>::Set(const float& value) const { glUniform1f(Location, value); }
+template<> inline void UniformHandle<glm::vec2>::Set(const glm::vec2& value) const { glUniform2f(Location, value.x, value.y); }
+template<> inline void UniformHandle<glm::vec3>::Set(const glm::vec3& value) const { glUniform3f(Location, value.x, value.y, value.z); }
+template<> inline void UniformHandle<glm::vec4>::Set(const glm::vec4& value) const { glUniform4f(Location, value.x, value.y, value.z, value.w); }
+template<> inline void UniformHandle<glm::mat4>::Set(const glm::mat4& value) const { glUniformMatrix4fv(Location, 1, GL_FALSE, &value[0][0]); }
+
+// =============================================================================
+// Shader
+// =============================================================================
+// Program linked from a vertex and a fragment shader, or from a compute shader
+// alone. Compile and link errors are written to std::cerr. With the
+// ProgramCache on, programs linked before are loaded from their binaries.
+// The active uniforms are looked up once after linking, so uploading by name
+// does not ask the driver again.
 class Shader
 {
 public:
     Shader(const std::string& vertexSrc, const std::string& fragmentSrc);
+    // A compute program, run with Dispatch
+    explicit Shader(const std::string& computeSrc);
     ~Shader();
 
     void Bind() const;
     void Unbind() const;
+    // Binds the compute program and runs groupsX*groupsY*groupsZ work groups
+    void Dispatch(GLuint groupsX, GLuint groupsY = 1, GLuint groupsZ = 1) const;
     void UploadUniformFloat2(const std::string& name,
         const glm::vec2& vector);
     void UploadUniformFloat3(const std::string& name,
@@ -25,12 +70,31 @@ public:
     void UploadUniformFloat(const std::string& name,
         const float flpt);
 
+    // Handle of a uniform for the hot paths, for example
+    // auto model = shader.Uniform<glm::mat4>("u_model");
+    template<typename T>
+    UniformHandle<T> Uniform(const std::string& name) const {
+        return UniformHandle<T>(GetUniformLocation(name));
+    }
+    // Location of an active uniform, -1 if the shader does not have it
+    GLint GetUniformLocation(const std::string& name) const;
+
+    // If the shaders compiled and the program linked
+    bool IsLinked() const { return Linked; }
+
 private:
-    GLuint VertexShader;
-    GLuint FragmentShader;
     GLuint ShaderProgram;
+    bool Linked = false;
+    std::unordered_map<std::string, GLint> UniformLocations;
 
-    void CompileShader(GLenum shaderType, const std::string& shaderSrc);
+    // Compiles a shader and attaches it to the program
+    GLuint CompileShader(GLenum shaderType, const std::string& shaderSrc);
+    // Links the program from the binary in the ProgramCache, if there is one
+    bool LoadCached(const std::string& cacheKey);
+    // Links the attached shaders and deletes them, the binary is stored in
+    // the ProgramCache unless the key is empty
+    void Link(std::initializer_list<GLuint> shaders, const std::string& cacheKey);
+    void CacheUniformLocations();
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,32 @@
+#include "ShaderStorageBuffer.h"
+
+ShaderStorageBuffer::ShaderStorageBuffer(const void* data, GLsizeiptr size, GLuint binding,
+	GLenum usage)
+	: Binding(binding), Size(size), Usage(usage) {
+	glGenBuffers(1, &ShaderStorageBufferID);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, ShaderStorageBufferID);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, size, data, usage);
+	Bind();
+}
+ShaderStorageBuffer::~ShaderStorageBuffer() {
+	glDeleteBuffers(1, &ShaderStorageBufferID);
+}
+
+// Bind the buffer to its binding point
+void ShaderStorageBuffer::Bind() const {
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, Binding, ShaderStorageBufferID);
+}
+
+// Fill out a specific segment of the buffer given by an offset and a size.
+void ShaderStorageBuffer::BufferSubData(GLintptr offset, GLsizeiptr size, const void* data) const {
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, ShaderStorageBufferID);
+	glBufferSubData(GL_SHADER_STORAGE_BUFFER, offset, size, data);
+}
+
+// Replace the whole buffer with a new one of another size, the binding
+// point keeps it
+void ShaderStorageBuffer::BufferData(const void* data, GLsizeiptr size) {
+	Size = size;
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, ShaderStorageBufferID);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, size, data, Usage);
+}
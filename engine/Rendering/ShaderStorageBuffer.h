@@ -0,0 +1,41 @@
+#ifndef SHADERSTORAGEBUFFER_H_
+#define SHADERSTORAGEBUFFER_H_
+
+#include <glad/glad.h>
+
+// =============================================================================
+// ShaderStorageBuffer
+// =============================================================================
+// Buffer the shaders read and write as a std430 buffer block at a binding
+// point. Unlike a uniform block it can hold an array as long as the buffer.
+class ShaderStorageBuffer
+{
+public:
+	// The buffer is bound to the binding point on construction
+	ShaderStorageBuffer(const void* data, GLsizeiptr size, GLuint binding,
+		GLenum usage = GL_DYNAMIC_DRAW);
+	~ShaderStorageBuffer();
+
+	ShaderStorageBuffer(const ShaderStorageBuffer&) = delete;
+	ShaderStorageBuffer& operator=(const ShaderStorageBuffer&) = delete;
+
+	// Bind the buffer to its binding point
+	void Bind() const;
+
+	// Fill out a specific segment of the buffer given by an offset and a size.
+	void BufferSubData(GLintptr offset, GLsizeiptr size, const void* data) const;
+	// Replace the whole buffer with a new one of another size
+	void BufferData(const void* data, GLsizeiptr size);
+
+	inline GLuint GetID() const { return ShaderStorageBufferID; }
+	inline GLuint GetBinding() const { return Binding; }
+	inline GLsizeiptr GetSize() const { return Size; }
+
+private:
+	GLuint ShaderStorageBufferID;
+	GLuint Binding;
+	GLsizeiptr Size;
+	GLenum Usage;
+};
+
+#endif // SHADERSTORAGEBUFFER_H_
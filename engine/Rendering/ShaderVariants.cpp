@@ -0,0 +1,49 @@
+#include "ShaderVariants.h"
+
+#include <algorithm>
+
+ShaderVariants::ShaderVariants(const std::string& vertexSrc, const std::string& fragmentSrc,
+	const std::vector<std::string>& features, SetupFunction setup)
+	: VertexSource(vertexSrc), FragmentSource(fragmentSrc), Features(features), Setup(setup),
+	Variants(size_t(1) << features.size()) {
+}
+
+const std::shared_ptr<Shader>& ShaderVariants::Get(unsigned int mask) {
+	//bits past the last feature mean nothing
+	mask &= static_cast<unsigned int>(Variants.size() - 1);
+	std::shared_ptr<Shader>& variant = Variants[mask];
+	if (variant)
+		return variant;
+
+	std::vector<std::string> defines;
+	for (size_t i = 0; i < Features.size(); i++) {
+		if (mask & (1u << i))
+			defines.push_back(Features[i]);
+	}
+	variant = std::make_shared<Shader>(WithDefines(VertexSource, defines),
+		WithDefines(FragmentSource, defines));
+	if (Setup) {
+		variant->Bind();
+		Setup(*variant, mask);
+	}
+	return variant;
+}
+
+size_t ShaderVariants::GetVariantCount() const {
+	return std::count_if(Variants.begin(), Variants.end(),
+		[](const std::shared_ptr<Shader>& variant) { return variant != nullptr; });
+}
+
+std::string ShaderVariants::WithDefines(const std::string& source, const std::vector<std::string>& defines) {
+	std::string lines;
+	for (const std::string& define : defines)
+		lines += "#define " + define + "\n";
+	//#version has to stay the first thing in the source
+	const size_t version = source.find("#version");
+	if (version == std::string::npos)
+		return lines + source;
+	const size_t end = source.find('\n', version);
+	if (end == std::string::npos)
+		return source + "\n" + lines;
+	return source.substr(0, end + 1) + lines + source.substr(end + 1);
+}
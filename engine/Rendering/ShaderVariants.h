@@ -0,0 +1,48 @@
+#ifndef SHADERVARIANTS_H_
+#define SHADERVARIANTS_H_
+
+#include "Shader.h"
+#include "functional"
+#include "memory"
+#include "string"
+#include "vector"
+
+// =============================================================================
+// ShaderVariants
+// =============================================================================
+// The programs built from one vertex and fragment source with different
+// features turned on. A feature is a #define put after the #version line of
+// both sources, so the shaders leave out the code of a feature that is off
+// with #ifdef instead of branching on a uniform for every fragment. Feature
+// i is bit i of a mask. A variant is compiled the first time it is asked for
+// and kept after that.
+class ShaderVariants
+{
+public:
+	// Called on every variant once it is made, with the program bound and
+	// the mask of its features, for the uniforms that are set once and the
+	// handles of the ones set while drawing
+	using SetupFunction = std::function<void(Shader&, unsigned int mask)>;
+
+	// features - the names of the #defines, in the order of their bits
+	ShaderVariants(const std::string& vertexSrc, const std::string& fragmentSrc,
+		const std::vector<std::string>& features, SetupFunction setup = nullptr);
+
+	// The program with the features of the bits set in mask
+	const std::shared_ptr<Shader>& Get(unsigned int mask);
+
+	// Variants built so far, compiled or loaded from the ProgramCache
+	size_t GetVariantCount() const;
+
+	// The source with a #define for each name after its #version line
+	static std::string WithDefines(const std::string& source, const std::vector<std::string>& defines);
+
+private:
+	std::string VertexSource;
+	std::string FragmentSource;
+	std::vector<std::string> Features;
+	SetupFunction Setup;
+	std::vector<std::shared_ptr<Shader>> Variants;	// by mask, empty until asked for
+};
+
+#endif // SHADERVARIANTS_H_
@@ -0,0 +1,52 @@
+#include "StreamBuffer.h"
+
+StreamBuffer::StreamBuffer(GLsizeiptr regionSize, unsigned int regions)
+	: RegionSize(regionSize), RegionCount(regions), Current(regions - 1),
+	Fences(regions, nullptr) {
+	const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	glGenBuffers(1, &StreamBufferID);
+	glBindBuffer(GL_ARRAY_BUFFER, StreamBufferID);
+	glBufferStorage(GL_ARRAY_BUFFER, RegionSize * RegionCount, nullptr, flags);
+	Mapped = static_cast<unsigned char*>(glMapBufferRange(GL_ARRAY_BUFFER, 0,
+		RegionSize * RegionCount, flags));
+}
+StreamBuffer::~StreamBuffer() {
+	for (GLsync fence : Fences) {
+		if (fence)
+			glDeleteSync(fence);
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, StreamBufferID);
+	glUnmapBuffer(GL_ARRAY_BUFFER);
+	glDeleteBuffers(1, &StreamBufferID);
+}
+
+// Moves to the next region, waiting for the GPU if it still reads it
+void* StreamBuffer::BeginFrame() {
+	Current = (Current + 1) % RegionCount;
+	GLsync& fence = Fences[Current];
+	if (fence) {
+		GLenum result = glClientWaitSync(fence, 0, 0);
+		if (result == GL_TIMEOUT_EXPIRED) {
+			Stalls++;
+			//flushes once so the fence is sure to be signaled at some point
+			GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+			do {
+				result = glClientWaitSync(fence, flags, 1000000);
+				flags = 0;
+			} while (result == GL_TIMEOUT_EXPIRED);
+		}
+		glDeleteSync(fence);
+		fence = nullptr;
+	}
+	return Mapped + GetOffset();
+}
+
+// Fences the current region, call after the draws reading it
+void StreamBuffer::EndFrame() {
+	Fences[Current] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+// Bind the buffer as a vertex buffer
+void StreamBuffer::Bind() const {
+	glBindBuffer(GL_ARRAY_BUFFER, StreamBufferID);
+}
@@ -0,0 +1,58 @@
+#ifndef STREAMBUFFER_H_
+#define STREAMBUFFER_H_
+
+#include <glad/glad.h>
+#include "BufferLayout.h"
+#include "vector"
+
+// =============================================================================
+// StreamBuffer
+// =============================================================================
+// Vertex buffer for data written again every frame. The buffer is created
+// once with glBufferStorage and stays mapped, split in regions that are used
+// one frame after the other. Each region is fenced when the frame that read
+// it is submitted, and only waited for when the ring comes back to it, so the
+// CPU writes straight into GPU memory without re-specifying the buffer and
+// without waiting on draws still in flight.
+class StreamBuffer
+{
+public:
+	// regionSize - bytes that can be written each frame
+	// regions - frames the GPU may be behind before the CPU has to wait
+	StreamBuffer(GLsizeiptr regionSize, unsigned int regions = 3);
+	~StreamBuffer();
+
+	StreamBuffer(const StreamBuffer&) = delete;
+	StreamBuffer& operator=(const StreamBuffer&) = delete;
+
+	// Moves to the next region, waiting for the GPU to be done reading it if
+	// it still is. Returns where the frame can write its data.
+	void* BeginFrame();
+	// Fences the current region, call after the draws reading it
+	void EndFrame();
+
+	// Bytes from the start of the buffer to the current region
+	inline GLintptr GetOffset() const { return Current * RegionSize; }
+	inline GLsizeiptr GetRegionSize() const { return RegionSize; }
+	// How many times BeginFrame had to wait for the GPU
+	inline unsigned long long GetStallCount() const { return Stalls; }
+
+	// Bind the buffer as a vertex buffer
+	void Bind() const;
+
+	// Set/Get buffer layout
+	const BufferLayout& GetLayout() const { return Layout; }
+	void SetLayout(const BufferLayout& layout) { Layout = layout; }
+
+private:
+	GLuint StreamBufferID;
+	GLsizeiptr RegionSize;
+	unsigned int RegionCount;
+	unsigned int Current;
+	unsigned char* Mapped;
+	std::vector<GLsync> Fences;		// one per region, null when not in flight
+	unsigned long long Stalls = 0;
+	BufferLayout Layout;
+};
+
+#endif // STREAMBUFFER_H_
@@ -1,5 +1,6 @@
 // This is the TextureManager.cpp
 #include "TextureManager.h"
+#include "RenderCommands.h"
 
 #include <iostream>
 
@@ -15,8 +16,7 @@ bool TextureManager::LoadTexture2DRGBA(const std::string& name, const std::strin
 
     GLuint tex;
     glGenTextures(1, &tex);
-    glActiveTexture(GL_TEXTURE0 + unit); // Texture Unit
-    glBindTexture(GL_TEXTURE_2D, tex);
+    RenderCommands::BindTexture(unit, GL_TEXTURE_2D, tex); // Texture Unit
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
 
     if (mipMap)
@@ -38,6 +38,7 @@ bool TextureManager::LoadTexture2DRGBA(const std::string& name, const std::strin
     texture.name = name;
     texture.filePath = filePath;
     texture.unit = unit;
+    texture.id = tex;
     texture.type = Texture2D;
 
     this->Textures.push_back(texture);
@@ -60,8 +61,7 @@ bool TextureManager::LoadCubeMapRGBA(const std::string& name, const std::string&
     /*Generate a texture object and upload the loaded image to it.*/
     GLuint tex;
     glGenTextures(1, &tex);
-    glActiveTexture(GL_TEXTURE0 + unit); // Texture Unit
-    glBindTexture(GL_TEXTURE_CUBE_MAP, tex);
+    RenderCommands::BindTexture(unit, GL_TEXTURE_CUBE_MAP, tex); // Texture Unit
 
     for (unsigned int i = 0; i < 6; i++) {
         glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
@@ -87,6 +87,7 @@ bool TextureManager::LoadCubeMapRGBA(const std::string& name, const std::string&
     texture.name = name;
     texture.filePath = filePath;
     texture.unit = unit;
+    texture.id = tex;
     texture.type = CubeMap;
 
     this->Textures.push_back(texture);
@@ -95,6 +96,14 @@ bool TextureManager::LoadCubeMapRGBA(const std::string& name, const std::string&
     return true;
 }
 
+TextureManager::~TextureManager()
+{
+    for (const auto& texture : this->Textures)
+    {
+        RenderCommands::ForgetTexture(texture.id);
+        glDeleteTextures(1, &texture.id);
+    }
+}
 
 GLuint TextureManager::GetUnitByName(const std::string& name) const
 {
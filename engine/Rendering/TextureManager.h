@@ -23,6 +23,7 @@ public:
         std::string name;
         std::string filePath;
         GLuint unit;
+        GLuint id;
         TextureManager::TextureType type;
     };
 
@@ -0,0 +1,66 @@
+#include "UniformBuffer.h"
+
+#include <cstring>
+
+UniformBufferLayout::UniformBufferLayout(const std::initializer_list<BufferAttribute>& members)
+	: Members(members) {
+	GLuint offset = 0;
+	for (auto& member : Members) {
+		const GLuint alignment = Std140Alignment(member.Type);
+		offset = (offset + alignment - 1) / alignment * alignment;
+		member.Offset = offset;
+		member.Size = Std140Size(member.Type);
+		offset += member.Size;
+	}
+	//a block takes whole vec4s
+	Size = (offset + 15) / 16 * 16;
+}
+
+GLuint UniformBufferLayout::GetOffset(const std::string& name) const {
+	for (const auto& member : Members) {
+		if (member.Name == name)
+		    return member.Offset;
+	}
+	std::cerr << "Uniform block has no member " << name << "\n";
+	return 0;
+}
+
+UniformBuffer::UniformBuffer(const UniformBufferLayout& layout, GLuint binding)
+	: Binding(binding), Layout(layout), Data(layout.GetSize(), 0) {
+	glGenBuffers(1, &UniformBufferID);
+	glBindBuffer(GL_UNIFORM_BUFFER, UniformBufferID);
+	glBufferData(GL_UNIFORM_BUFFER, Data.size(), Data.data(), GL_DYNAMIC_DRAW);
+	Bind();
+}
+UniformBuffer::~UniformBuffer() {
+	glDeleteBuffers(1, &UniformBufferID);
+}
+
+// Bind the buffer to its binding point
+void UniformBuffer::Bind() const {
+	glBindBufferBase(GL_UNIFORM_BUFFER, Binding, UniformBufferID);
+}
+
+void UniformBuffer::Set(GLuint offset, int value) { Write(offset, &value, sizeof(value)); }
+void UniformBuffer::Set(GLuint offset, float value) { Write(offset, &value, sizeof(value)); }
+void UniformBuffer::Set(GLuint offset, const glm::vec2& value) { Write(offset, &value[0], sizeof(float) * 2); }
+void UniformBuffer::Set(GLuint offset, const glm::vec3& value) { Write(offset, &value[0], sizeof(float) * 3); }
+void UniformBuffer::Set(GLuint offset, const glm::vec4& value) { Write(offset, &value[0], sizeof(float) * 4); }
+void UniformBuffer::Set(GLuint offset, const glm::mat4& value) { Write(offset, &value[0][0], sizeof(float) * 16); }
+
+void UniformBuffer::Write(GLuint offset, const void* data, GLuint size) {
+	//values that did not change do not need another upload
+	if (std::memcmp(&Data[offset], data, size) == 0)
+		return;
+	std::memcpy(&Data[offset], data, size);
+	Dirty = true;
+}
+
+// Send the block to the GPU if anything changed since the last upload
+void UniformBuffer::Upload() {
+	if (!Dirty)
+		return;
+	glBindBuffer(GL_UNIFORM_BUFFER, UniformBufferID);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, Data.size(), Data.data());
+	Dirty = false;
+}
@@ -0,0 +1,106 @@
+#ifndef UNIFORMBUFFER_H_
+#define UNIFORMBUFFER_H_
+
+#include <glad/glad.h>
+#include "glm/glm.hpp"
+#include "BufferLayout.h"
+#include "string"
+#include "vector"
+
+// =============================================================================
+// Std140 alignment and size
+// =============================================================================
+// Where a member of a std140 uniform block starts and how many bytes it
+// takes. Vectors of three take the alignment of four and matrices are laid
+// out as arrays of four component columns.
+constexpr GLuint Std140Alignment(ShaderDataType type)
+{
+    switch (type)
+    {
+    case ShaderDataType::Float2: return 4 * 2;
+    case ShaderDataType::Int2: return 4 * 2;
+    case ShaderDataType::Float3: return 4 * 4;
+    case ShaderDataType::Float4: return 4 * 4;
+    case ShaderDataType::Int3: return 4 * 4;
+    case ShaderDataType::Int4: return 4 * 4;
+    case ShaderDataType::Mat3: return 4 * 4;
+    case ShaderDataType::Mat4: return 4 * 4;
+    default: return 4;
+    }
+}
+
+constexpr GLuint Std140Size(ShaderDataType type)
+{
+    switch (type)
+    {
+    case ShaderDataType::Mat3: return 4 * 4 * 3;
+    case ShaderDataType::Bool: return 4;
+    default: return ShaderDataTypeSize(type);
+    }
+}
+
+// =============================================================================
+// UniformBufferLayout
+// =============================================================================
+// The members of a std140 uniform block in the order the shader declares
+// them, with the offsets the shader expects them at.
+class UniformBufferLayout
+{
+public:
+    UniformBufferLayout(const std::initializer_list<BufferAttribute>& members);
+
+    inline const std::vector<BufferAttribute>& GetMembers() const { return Members; }
+    // Size of the whole block in bytes
+    inline GLuint GetSize() const { return Size; }
+    // Offset of a member by name, looked up when setting up, not per frame
+    GLuint GetOffset(const std::string& name) const;
+
+private:
+    std::vector<BufferAttribute> Members;
+    GLuint Size = 0;
+};
+
+// =============================================================================
+// UniformBuffer
+// =============================================================================
+// Uniform block shared by every shader that declares it at the same binding.
+// The members are written to a copy on the CPU and the whole block is sent in
+// one upload, so state shared by the shaders is written once per frame.
+class UniformBuffer
+{
+public:
+    // The buffer is bound to the binding point on construction
+    UniformBuffer(const UniformBufferLayout& layout, GLuint binding);
+    ~UniformBuffer();
+
+    UniformBuffer(const UniformBuffer&) = delete;
+    UniformBuffer& operator=(const UniformBuffer&) = delete;
+
+    // Bind the buffer to its binding point
+    void Bind() const;
+
+    // Write a member at an offset from the layout
+    void Set(GLuint offset, int value);
+    void Set(GLuint offset, float value);
+    void Set(GLuint offset, const glm::vec2& value);
+    void Set(GLuint offset, const glm::vec3& value);
+    void Set(GLuint offset, const glm::vec4& value);
+    void Set(GLuint offset, const glm::mat4& value);
+
+    // Send the block to the GPU if anything changed since the last upload
+    void Upload();
+
+    inline const UniformBufferLayout& GetLayout() const { return Layout; }
+
+private:
+    void Write(GLuint offset, const void* data, GLuint size);
+
+private:
+    GLuint UniformBufferID;
+    GLuint Binding;
+    UniformBufferLayout Layout;
+    std::vector<unsigned char> Data;
+    bool Dirty = true;
+};
+
+#endif // UNIFORMBUFFER_H_
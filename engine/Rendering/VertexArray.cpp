@@ -1,38 +1,52 @@
 #include "VertexArray.h"
+#include "RenderCommands.h"
 
 // Constructor & Destructor
 VertexArray::VertexArray() {
 	glGenVertexArrays(1, &m_vertexArrayID);
-	glBindVertexArray(m_vertexArrayID);
+	Bind();
 }
 VertexArray::~VertexArray() {
+	RenderCommands::ForgetVertexArray(m_vertexArrayID);
 	glDeleteVertexArrays(1, &m_vertexArrayID);
 }
 
 // Bind vertex array
 void VertexArray::Bind() const {
-	glBindVertexArray(m_vertexArrayID);
+	RenderCommands::BindVertexArray(m_vertexArrayID);
 }
 // Unbind vertex array
 void VertexArray::Unbind() const {
-	glBindVertexArray(0);
+	RenderCommands::BindVertexArray(0);
 }
 
 
 // Add vertex buffer. This method utilizes the BufferLayout internal to
 // the vertex buffer to set up the vertex attributes. Notice that
 // this function opens for the definition of several vertex buffers.
-void VertexArray::AddVertexBuffer(const std::shared_ptr<VertexBuffer>& vertexBuffer) {
+void VertexArray::AddVertexBuffer(const std::shared_ptr<VertexBuffer>& vertexBuffer, GLuint divisor) {
 	VertexBuffers.push_back(vertexBuffer);
+	Bind();
 	vertexBuffer->Bind();
-	const auto layout = vertexBuffer->GetLayout();
+	AddAttributes(vertexBuffer->GetLayout(), divisor);
+}
+void VertexArray::AddVertexBuffer(const std::shared_ptr<StreamBuffer>& streamBuffer, GLuint divisor) {
+	StreamBuffers.push_back(streamBuffer);
+	Bind();
+	streamBuffer->Bind();
+	AddAttributes(streamBuffer->GetLayout(), divisor);
+}
+
+// Points the next attribute locations at the bound buffer
+void VertexArray::AddAttributes(const BufferLayout& layout, GLuint divisor) {
 	const auto& attributes = layout.GetAttributes();
 	for (unsigned int i = 0; i < attributes.size(); i++)
 	{
 		const auto& attribute = attributes[i];
-		glEnableVertexAttribArray(i);
-		glVertexAttribPointer(i, ShaderDataTypeComponentCount(attribute.Type), ShaderDataTypeToOpenGLBaseType(attribute.Type), attribute.Normalized, layout.GetStride(), (const void*)attribute.Offset);
-		
+		const GLuint location = AttributeCount++;
+		glEnableVertexAttribArray(location);
+		glVertexAttribPointer(location, ShaderDataTypeComponentCount(attribute.Type), ShaderDataTypeToOpenGLBaseType(attribute.Type), attribute.Normalized, layout.GetStride(), (const void*)attribute.Offset);
+		glVertexAttribDivisor(location, divisor);
 	}
 	
 
@@ -40,5 +54,6 @@ void VertexArray::AddVertexBuffer(const std::shared_ptr<VertexBuffer>& vertexBuf
 // Set index buffer
 void VertexArray::SetIndexBuffer(const std::shared_ptr<IndexBuffer>& indexBuffer) {
 	IdxBuffer = indexBuffer;
+	Bind();
 	IdxBuffer->Bind();
 }
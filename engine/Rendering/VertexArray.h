@@ -3,6 +3,8 @@
 
 #include "IndexBuffer.h"
 #include "VertexBuffer.h"
+#include "StreamBuffer.h"
+#include "IndirectBuffer.h"
 #include "iostream"
 #include "vector"
 #include "ShaderDataTypes.h"
@@ -22,18 +24,34 @@ public:
 	
 	// Add vertex buffer. This method utilizes the BufferLayout internal to
 	// the vertex buffer to set up the vertex attributes. Notice that
-	// this function opens for the definition of several vertex buffers.
-	void AddVertexBuffer(const std::shared_ptr<VertexBuffer>& vertexBuffer);
+	// this function opens for the definition of several vertex buffers,
+	// their attributes get the locations after the ones already added.
+	// A divisor of 0 reads one element per vertex, a divisor of 1 reads one
+	// per instance for instanced draws.
+	void AddVertexBuffer(const std::shared_ptr<VertexBuffer>& vertexBuffer, GLuint divisor = 0);
+	// Same for a buffer streamed every frame. Its attributes point at the
+	// first region, instanced draws reach the others with a base instance.
+	void AddVertexBuffer(const std::shared_ptr<StreamBuffer>& streamBuffer, GLuint divisor = 0);
 	// Set index buffer
 	void SetIndexBuffer(const std::shared_ptr<IndexBuffer>& indexBuffer);
 
 	//Get the index buffer
 	const std::shared_ptr<IndexBuffer>& GetIndexBuffer() const { return IdxBuffer; }
+	// Indirect command drawing the whole index buffer instances times, reading
+	// the instanced vertex buffers from baseInstance
+	DrawElementsIndirectCommand GetIndirectCommand(GLuint instances = 1, GLuint baseInstance = 0) const {
+		return { IdxBuffer->GetCount(), instances, 0, 0, baseInstance };
+	}
 
 private:
 	GLuint m_vertexArrayID;
+	GLuint AttributeCount = 0;	// locations used by the added vertex buffers
 	std::vector<std::shared_ptr<VertexBuffer>> VertexBuffers;
 	std::shared_ptr<IndexBuffer> IdxBuffer;
+	std::vector<std::shared_ptr<StreamBuffer>> StreamBuffers;
+
+	// Points the next attribute locations at the bound buffer
+	void AddAttributes(const BufferLayout& layout, GLuint divisor);
 
 	// Get the vertex buffers
 	const std::vector<std::shared_ptr<VertexBuffer>>& GetVertexBuffers() const { return VertexBuffers; }
@@ -1,9 +1,10 @@
 #include "VertexBuffer.h"
 
-VertexBuffer::VertexBuffer(const void* vertices, GLsizei size){
+VertexBuffer::VertexBuffer(const void* vertices, GLsizei size, GLenum usage)
+	: Size(size), Usage(usage) {
 	glGenBuffers(1, &VertexBufferID);
 	glBindBuffer(GL_ARRAY_BUFFER, VertexBufferID);
-	glBufferData(GL_ARRAY_BUFFER, size, vertices, GL_STATIC_DRAW);
+	glBufferData(GL_ARRAY_BUFFER, size, vertices, usage);
 }
 VertexBuffer::~VertexBuffer(){
 	glDeleteBuffers(1, &VertexBufferID);
@@ -23,4 +24,11 @@ void VertexBuffer::Unbind() const {
 // Fill out a specific segment of the buffer given by an offset and a size.
 void VertexBuffer::BufferSubData(GLintptr offset, GLsizeiptr size, const void* data) const {
 	glBufferSubData(GL_ARRAY_BUFFER, offset, size, data);
-}
\ No newline at end of file
+}
+
+// Replace the whole buffer with a new one of another size.
+void VertexBuffer::BufferData(const void* data, GLsizeiptr size) {
+	Size = size;
+	glBindBuffer(GL_ARRAY_BUFFER, VertexBufferID);
+	glBufferData(GL_ARRAY_BUFFER, size, data, Usage);
+}
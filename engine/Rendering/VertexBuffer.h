@@ -8,8 +8,9 @@ class VertexBuffer
 {
 public:
 	// Constructor. It initializes with a data buffer and the size of it.
-	// Note that the buffer will be bound on construction.
-	VertexBuffer(const void* vertices, GLsizei size);
+	// Note that the buffer will be bound on construction. Buffers that are
+	// rewritten while drawing should use GL_DYNAMIC_DRAW.
+	VertexBuffer(const void* vertices, GLsizei size, GLenum usage = GL_STATIC_DRAW);
 	~VertexBuffer();
 
 	// Bind the vertex buffer
@@ -20,6 +21,10 @@ public:
 
 	// Fill out a specific segment of the buffer given by an offset and a size.
 	void BufferSubData(GLintptr offset, GLsizeiptr size, const void* data) const;
+	// Replace the whole buffer with a new one of another size. The vertex
+	// arrays using it keep pointing to it. Binds the buffer.
+	void BufferData(const void* data, GLsizeiptr size);
+	GLsizeiptr GetSize() const { return Size; }
 
 	// Set/Get buffer layout
 	const BufferLayout& GetLayout() const { return Layout; }
@@ -27,6 +32,8 @@ public:
 
 private:
 	GLuint VertexBufferID;
+	GLsizeiptr Size;
+	GLenum Usage;
 	BufferLayout Layout;
 };
 